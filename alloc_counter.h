@@ -0,0 +1,61 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// ** Allocation counter **
+// Replaces the global operator new/delete with versions that count the heap
+// allocations (and bytes requested) made by the calling thread. The counters
+// are thread-local, so the cost is one TLS increment per allocation.
+// Replacement operators must be defined exactly once per program; each of
+// our programs is a single translation unit, so include this from its .cpp.
+//
+//     AllocationScope scope;
+//     sys.findUserByUsername("admin");
+//     assert(scope.allocations() == 0);
+
+namespace alloc_counter {
+inline thread_local size_t allocations = 0;
+inline thread_local size_t bytes = 0;
+}
+
+class AllocationScope {
+private:
+    size_t startAllocations;
+    size_t startBytes;
+
+public:
+    AllocationScope() : startAllocations(alloc_counter::allocations), startBytes(alloc_counter::bytes) {}
+    size_t allocations() const { return alloc_counter::allocations - startAllocations; }
+    size_t bytes() const { return alloc_counter::bytes - startBytes; }
+};
+
+// GCC pairs the inlined free() below with the new-expression that produced the
+// pointer and flags a mismatch; here malloc/free is the intended pairing.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    ++alloc_counter::allocations;
+    alloc_counter::bytes += size;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return ::operator new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    ++alloc_counter::allocations;
+    alloc_counter::bytes += size;
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return ::operator new(size, tag); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#endif // ALLOC_COUNTER_H
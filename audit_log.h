@@ -0,0 +1,330 @@
+#ifndef AUDIT_LOG_H
+#define AUDIT_LOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <istream>
+#include <locale>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// ** Audit log **
+// Every mutation (accounts, events, registrations, check-ins, allocations,
+// contact changes) is recorded as a small fixed-size AuditRecord:
+//
+//     AuditLog::record(AuditType::Registered, eventId, attendeeId);
+//
+// The producer side is a bounded lock-free MPSC queue (per-cell sequence
+// numbers, one CAS to claim a cell): recording never allocates or touches
+// the file, and when the queue is full the record is dropped and counted
+// rather than waiting. A background thread drains the queue and appends
+// compact binary records to the log file; the drop count is written as its
+// own record so gaps are visible. When the queue is empty the writer parks
+// on a condition variable, and only the record that finds it parked takes
+// its lock to wake it, so an idle log costs no wakeups. The acting user is a per-thread
+// value set at login (AuditLog::setActor); 0 means no one is logged in.
+// While the log is closed, record() costs one relaxed load.
+//
+// File format: the 8 bytes "EMSAUDIT", a version byte (1), then records:
+//
+//     type        u8
+//     time        varint, microseconds since the previous record (the
+//                 first one: since the Unix epoch)
+//     actor, a, b, c
+//                 zigzag varints (meaning of a/b/c depends on the type)
+//     text        u8 length + bytes
+//
+// AuditLog::decode prints a file as text, one record per line (the
+// programs' --audit-decode mode). A record cut off by a crash ends decoding
+// with a note rather than an error.
+
+enum class AuditType : uint8_t {
+    Dropped,         // a = records lost because the queue was full
+    UserCreated,     // a = user ID, b = 1 if admin; text = username
+    UserDeleted,     // a = user ID; text = username
+    PasswordChanged, // a = user ID
+    EventCreated,    // a = event ID; text = name
+    EventEdited,     // a = event ID; text = field
+    EventDeleted,    // a = event ID
+    Registered,      // a = event ID, b = attendee or user ID
+    Unregistered,    // a = event ID, b = attendee ID
+    CheckedIn,       // a = event ID, b = attendee ID
+    Allocated,       // a = event ID, b = item ID, c = quantity
+    ContactUpdated,  // a = attendee ID
+    Count
+};
+
+struct AuditRecord {
+    uint64_t timeNs;  // system clock
+    int32_t actor;
+    int32_t a, b, c;
+    AuditType type;
+    uint8_t textLength;
+    char text[34];
+};
+
+class AuditLog {
+public:
+    static constexpr uint32_t kQueueSize = 1 << 14; // Power of two
+
+    static bool enabled() { return state().open.load(std::memory_order_relaxed); }
+
+    static void setActor(int userId) { actorSlot() = userId; }
+
+    static void record(AuditType type, int a = 0, int b = 0, int c = 0, std::string_view text = {}) {
+        if (!enabled()) return;
+        State& s = state();
+        uint64_t pos = s.enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &s.cells[pos & (kQueueSize - 1)];
+            uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (s.enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                s.dropped.fetch_add(1, std::memory_order_relaxed); // Full: the writer is behind
+                return;
+            } else {
+                pos = s.enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        AuditRecord& r = cell->record;
+        r.timeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        r.actor = actorSlot();
+        r.a = a; r.b = b; r.c = c;
+        r.type = type;
+        r.textLength = static_cast<uint8_t>(std::min(text.size(), sizeof r.text));
+        std::memcpy(r.text, text.data(), r.textLength);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // Pairs with the writer's fence before it parks
+        if (s.parked.load(std::memory_order_relaxed)) wakeWriter();
+    }
+
+    // Starts the writer thread appending to path. False if the file cannot
+    // be opened or the log is already open.
+    static bool open(const std::string& path) {
+        State& s = state();
+        if (s.writer.joinable()) return false;
+        s.file.open(path, std::ios::binary | std::ios::app);
+        if (!s.file) return false;
+        if (s.file.tellp() == 0) s.file.write(kMagic, sizeof kMagic).put(kVersion);
+        s.cells.reset(new Cell[kQueueSize]);
+        for (uint32_t i = 0; i < kQueueSize; ++i) s.cells[i].sequence.store(i, std::memory_order_relaxed);
+        s.enqueuePos.store(0);
+        s.dequeuePos = 0;
+        s.stopping.store(false);
+        s.writer = std::thread(writerLoop);
+        s.open.store(true, std::memory_order_release);
+        if (!s.closeAtExit) s.closeAtExit = std::atexit(close) == 0;
+        return true;
+    }
+
+    // EMS_AUDIT=<file> or "off"; otherwise defaultPath (nullptr: off)
+    static void openFromEnvironment(const char* defaultPath) {
+        const char* path = std::getenv("EMS_AUDIT");
+        if (!path || !*path) path = defaultPath;
+        if (!path || std::strcmp(path, "off") == 0) return;
+        if (!open(path)) std::fprintf(stderr, "Warn: Cannot open audit log %s.\n", path);
+    }
+
+    // Stops recording, writes everything queued and joins the writer
+    static void close() {
+        State& s = state();
+        if (!s.writer.joinable()) return;
+        s.open.store(false, std::memory_order_relaxed);
+        s.stopping.store(true, std::memory_order_release);
+        wakeWriter();
+        s.writer.join();
+        s.file.close();
+    }
+
+    // Writes one text line per record; returns the number of records
+    static size_t decode(std::istream& in, std::ostream& out) {
+        out.imbue(std::locale::classic());
+        char magic[sizeof kMagic];
+        if (!in.read(magic, sizeof magic) || std::memcmp(magic, kMagic, sizeof kMagic) != 0 || in.get() != kVersion) {
+            out << "Not an audit log (bad header).\n";
+            return 0;
+        }
+        size_t count = 0;
+        uint64_t timeUs = 0;
+        while (in.peek() != std::char_traits<char>::eof()) {
+            long long offset = static_cast<long long>(in.tellg());
+            int type = in.get();
+            uint64_t delta, actor, fields[3];
+            int length;
+            char text[256];
+            bool ok = readVarint(in, delta) && readVarint(in, actor) && readVarint(in, fields[0]) &&
+                      readVarint(in, fields[1]) && readVarint(in, fields[2]) && (length = in.get()) != EOF &&
+                      in.read(text, length);
+            if (!ok || type >= static_cast<int>(AuditType::Count)) {
+                out << "(truncated or corrupt record at byte " << offset << ")\n";
+                break;
+            }
+            timeUs += delta;
+            const TypeInfo& info = kTypes[type];
+            writeTime(out, timeUs);
+            out << " actor=" << unzigzag(actor) << ' ' << info.name;
+            for (int i = 0; i < 3; ++i)
+                if (info.fields[i]) out << ' ' << info.fields[i] << '=' << unzigzag(fields[i]);
+            if (info.text) out << ' ' << info.text << "=\"" << std::string_view(text, length) << '"';
+            out << '\n';
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    static constexpr char kMagic[8] = {'E', 'M', 'S', 'A', 'U', 'D', 'I', 'T'};
+    static constexpr char kVersion = 1;
+
+    struct TypeInfo { const char* name; const char* fields[3]; const char* text; };
+    static constexpr TypeInfo kTypes[static_cast<int>(AuditType::Count)] = {
+        {"dropped", {"records", nullptr, nullptr}, nullptr},
+        {"user-created", {"user", "admin", nullptr}, "name"},
+        {"user-deleted", {"user", nullptr, nullptr}, "name"},
+        {"password-changed", {"user", nullptr, nullptr}, nullptr},
+        {"event-created", {"event", nullptr, nullptr}, "name"},
+        {"event-edited", {"event", nullptr, nullptr}, "field"},
+        {"event-deleted", {"event", nullptr, nullptr}, nullptr},
+        {"registered", {"event", "attendee", nullptr}, nullptr},
+        {"unregistered", {"event", "attendee", nullptr}, nullptr},
+        {"checked-in", {"event", "attendee", nullptr}, nullptr},
+        {"allocated", {"event", "item", "quantity"}, nullptr},
+        {"contact-updated", {"attendee", nullptr, nullptr}, nullptr},
+    };
+
+    struct Cell {
+        std::atomic<uint64_t> sequence{0};
+        AuditRecord record;
+    };
+
+    struct State {
+        std::atomic<bool> open{false};
+        std::unique_ptr<Cell[]> cells;
+        std::atomic<uint64_t> enqueuePos{0};
+        uint64_t dequeuePos = 0;            // writer thread only
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> stopping{false};
+        std::atomic<bool> parked{false};    // The writer is waiting on wake
+        std::mutex parkLock;
+        std::condition_variable wake;
+        bool closeAtExit = false;           // atexit(close) registered
+        std::thread writer;
+        std::ofstream file;
+    };
+
+    static State& state() { static State s; return s; }
+
+    static void wakeWriter() {
+        State& s = state();
+        { std::lock_guard<std::mutex> lock(s.parkLock); } // The writer is inside wait() or has not parked
+        s.wake.notify_one();
+    }
+    static int& actorSlot() { thread_local int actor = 0; return actor; }
+
+    static uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+    static int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+    static void putVarint(std::string& out, uint64_t v) {
+        while (v >= 0x80) { out += static_cast<char>(v | 0x80); v >>= 7; }
+        out += static_cast<char>(v);
+    }
+
+    static bool readVarint(std::istream& in, uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            int byte = in.get();
+            if (byte == EOF) return false;
+            v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    static void encode(std::string& out, const AuditRecord& r, uint64_t& lastUs) {
+        uint64_t us = r.timeNs / 1000;
+        out += static_cast<char>(r.type);
+        putVarint(out, us >= lastUs ? us - lastUs : 0); // The clock can step back; keep the file monotonic
+        if (us > lastUs) lastUs = us;
+        putVarint(out, zigzag(r.actor));
+        putVarint(out, zigzag(r.a));
+        putVarint(out, zigzag(r.b));
+        putVarint(out, zigzag(r.c));
+        out += static_cast<char>(r.textLength);
+        out.append(r.text, r.textLength);
+    }
+
+    static void writeTime(std::ostream& out, uint64_t us) {
+        time_t seconds = static_cast<time_t>(us / 1000000);
+        tm utc;
+#ifdef _WIN32
+        gmtime_s(&utc, &seconds);
+#else
+        gmtime_r(&seconds, &utc);
+#endif
+        char stamp[64];
+        std::snprintf(stamp, sizeof stamp, "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ", utc.tm_year + 1900, utc.tm_mon + 1,
+                      utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, static_cast<int>(us % 1000000));
+        out << stamp;
+    }
+
+    // Drains the queue in batches; parks when it is empty until a record
+    // or close() wakes it
+    static void writerLoop() {
+        State& s = state();
+        std::string batch;
+        uint64_t lastUs = 0, droppedWritten = 0;
+        while (true) {
+            bool stopping = s.stopping.load(std::memory_order_acquire);
+            batch.clear();
+            while (true) {
+                Cell& cell = s.cells[s.dequeuePos & (kQueueSize - 1)];
+                if (cell.sequence.load(std::memory_order_acquire) != s.dequeuePos + 1) break;
+                encode(batch, cell.record, lastUs);
+                cell.sequence.store(s.dequeuePos + kQueueSize, std::memory_order_release);
+                ++s.dequeuePos;
+            }
+            uint64_t dropped = s.dropped.load(std::memory_order_relaxed);
+            if (dropped != droppedWritten) {
+                AuditRecord note = {};
+                note.timeNs = lastUs * 1000;
+                note.type = AuditType::Dropped;
+                note.a = static_cast<int32_t>(dropped - droppedWritten);
+                encode(batch, note, lastUs);
+                droppedWritten = dropped;
+            }
+            if (!batch.empty()) {
+                s.file.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+                s.file.flush();
+            } else if (stopping) {
+                return; // Checked before draining, so nothing recorded before close() is lost
+            } else {
+                std::unique_lock<std::mutex> lock(s.parkLock);
+                s.parked.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst); // Either we see the new record or its producer sees parked
+                Cell& next = s.cells[s.dequeuePos & (kQueueSize - 1)];
+                if (next.sequence.load(std::memory_order_acquire) != s.dequeuePos + 1
+                    && s.dropped.load(std::memory_order_relaxed) == droppedWritten && !s.stopping.load())
+                    s.wake.wait(lock);
+                s.parked.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+#endif // AUDIT_LOG_H
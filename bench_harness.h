@@ -0,0 +1,120 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <locale>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+#include "perf_counters.h"
+
+// ** Benchmark harness **
+// Times one operation at a time for the --bench mode of both programs.
+// Each benchmark is calibrated first: the batch size doubles until a batch
+// takes at least kMinBatch, so cheap lookups and whole-file loads are both
+// measured over a useful interval. One batch is then run as warmup and
+// kSamples batches are timed; the median ns/op is the headline number and
+// min/max show the spread. Results are written as CSV, one row per
+// benchmark and data size:
+//
+//     program,benchmark,size,iterations,median_ns,min_ns,max_ns
+//
+// With EMS_PERF=1 (perf_counters.h) four more columns give cycles,
+// instructions, cache misses and branch misses per operation over the
+// timed batches:
+//
+//     ...,cycles_per_op,instructions_per_op,cache_misses_per_op,branch_misses_per_op
+//
+// Sizes run from 10^2 up to a limit given on the command line (default
+// 10^5; 10^7 needs several GB for test.cpp's record types).
+
+// Keeps the compiler from discarding a result that is otherwise unused
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+class BenchRunner {
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::chrono::milliseconds kMinBatch{20};
+    static constexpr int kSamples = 5;
+
+    std::ostream& out;
+    std::string_view program;
+
+    template <typename Op>
+    static double timeBatch(Op& op, uint64_t iterations) {
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) op();
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+public:
+    BenchRunner(std::ostream& os, std::string_view programName) : out(os), program(programName) {
+        out.imbue(std::locale::classic()); // No digit grouping in the CSV
+        out << std::fixed << std::setprecision(1);
+        out << "program,benchmark,size,iterations,median_ns,min_ns,max_ns";
+        if (PerfCounters::active()) out << ",cycles_per_op,instructions_per_op,cache_misses_per_op,branch_misses_per_op";
+        out << '\n';
+    }
+
+    // op() performs one operation on data of the given size
+    template <typename Op>
+    void run(std::string_view name, size_t size, Op&& op) {
+        uint64_t iterations = 1;
+        while (timeBatch(op, iterations) < std::chrono::duration<double, std::nano>(kMinBatch).count() &&
+               iterations < (uint64_t(1) << 30))
+            iterations *= 2;
+        timeBatch(op, iterations); // Warmup at the final batch size
+        std::vector<double> perOp;
+        PerfSample before, after;
+        bool counting = PerfCounters::read(before);
+        for (int s = 0; s < kSamples; ++s) perOp.push_back(timeBatch(op, iterations) / double(iterations));
+        counting = counting && PerfCounters::read(after);
+        std::sort(perOp.begin(), perOp.end());
+        out << program << ',' << name << ',' << size << ',' << iterations << ','
+            << perOp[kSamples / 2] << ',' << perOp.front() << ',' << perOp.back();
+        if (PerfCounters::active()) {
+            PerfSample d = after - before;
+            double ops = counting ? double(iterations) * kSamples : 0;
+            auto per = [&](uint64_t v) { return ops > 0 ? double(v) / ops : 0.0; };
+            out << ',' << per(d.cycles) << ',' << per(d.instructions) << ',' << per(d.cacheMisses) << ',' << per(d.branchMisses);
+        }
+        out << '\n';
+        out.flush();
+    }
+};
+
+// Discards everything written to it (listings under benchmark)
+struct NullStreamBuf : std::streambuf {
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// 100, 1000, ... up to and including maxSize
+inline std::vector<size_t> benchSizes(size_t maxSize) {
+    std::vector<size_t> sizes;
+    for (size_t n = 100; n <= maxSize; n *= 10) sizes.push_back(n);
+    return sizes;
+}
+
+// Parses the optional size limit argument of --bench
+inline size_t benchMaxSize(int argc, char* argv[], int index) {
+    if (index >= argc) return 100000;
+    char* end = nullptr;
+    unsigned long long n = std::strtoull(argv[index], &end, 10);
+    return (end && *end == '\0' && n >= 100) ? static_cast<size_t>(n) : 100000;
+}
+
+#endif // BENCH_HARNESS_H
@@ -0,0 +1,100 @@
+#ifndef COMMAND_SCRIPT_H
+#define COMMAND_SCRIPT_H
+
+#include <charconv>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ** CommandLine **
+// Tokenizer for one line of a batch command script.
+// Tokens are separated by spaces/tabs. A token may be wrapped in double quotes
+// to include spaces; inside quotes "" stands for a literal quote. A '#' at the
+// start of a token begins a comment that runs to the end of the line.
+// Quotes are removed in place, so tokens are views into the caller's line and
+// parsing a line does not allocate once the token vector has warmed up.
+class CommandLine {
+private:
+    std::vector<std::string_view> tokens;
+
+public:
+    // Returns false (and leaves no tokens) on an unterminated quote.
+    bool parse(std::string& line) {
+        tokens.clear();
+        char* p = line.data();
+        char* end = p + line.size();
+        while (p < end) {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+            if (p == end || *p == '#') break;
+            if (*p == '"') {
+                char* out = ++p;
+                char* start = out;
+                bool closed = false;
+                while (p < end) {
+                    if (*p == '"') {
+                        if (p + 1 < end && p[1] == '"') { *out++ = '"'; p += 2; continue; }
+                        ++p; closed = true; break;
+                    }
+                    *out++ = *p++;
+                }
+                if (!closed) { tokens.clear(); return false; }
+                tokens.emplace_back(start, static_cast<size_t>(out - start));
+            } else {
+                char* start = p;
+                while (p < end && *p != ' ' && *p != '\t' && *p != '\r') ++p;
+                tokens.emplace_back(start, static_cast<size_t>(p - start));
+            }
+        }
+        return true;
+    }
+
+    size_t size() const { return tokens.size(); }
+    bool empty() const { return tokens.empty(); }
+    std::string_view operator[](size_t i) const { return tokens[i]; }
+    std::string str(size_t i) const { return std::string(tokens[i]); }
+
+    // Parse token i as a whole decimal integer.
+    bool getInt(size_t i, int& out) const {
+        if (i >= tokens.size()) return false;
+        std::string_view t = tokens[i];
+        auto res = std::from_chars(t.data(), t.data() + t.size(), out);
+        return res.ec == std::errc() && res.ptr == t.data() + t.size();
+    }
+};
+
+// Runs a command script: one command per line, no prompts.
+// handler(const CommandLine&) returns false for an unknown command or wrong
+// arguments; exceptions it throws are reported with the line number and the
+// script carries on. "exit" or "quit" ends the script early.
+// Returns the number of lines that failed.
+template <typename Handler>
+int runCommandScript(std::istream& in, Handler&& handler) {
+    std::string line;
+    CommandLine cmd;
+    int lineNo = 0;
+    int failures = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (!cmd.parse(line)) {
+            std::cerr << "Script line " << lineNo << ": unterminated quote\n";
+            ++failures;
+            continue;
+        }
+        if (cmd.empty()) continue;
+        if (cmd[0] == "exit" || cmd[0] == "quit") break;
+        try {
+            if (!handler(cmd)) {
+                std::cerr << "Script line " << lineNo << ": unknown command or bad arguments: " << cmd[0] << "\n";
+                ++failures;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Script line " << lineNo << ": " << e.what() << "\n";
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+#endif // COMMAND_SCRIPT_H
@@ -0,0 +1,158 @@
+#ifndef CSV_SCANNER_H
+#define CSV_SCANNER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CSV_SCANNER_SSE2 1
+#endif
+
+// Raw (still quoted) field views of one record
+using CsvFields = std::vector<std::string_view>;
+
+// ** CsvScanner **
+// Splits an in-memory data file into records and fields using the quoting
+// rules of RFC 4180: a field wrapped in double quotes may contain commas,
+// newlines and "" (a literal quote). CR before LF is dropped, blank lines are
+// skipped.
+// Input is classified 64 bytes at a time: SSE2 compares produce bitmasks of
+// quotes, commas and newlines, a prefix-XOR of the quote mask marks the bytes
+// that are inside quotes, and what remains are the structural commas and
+// newlines, visited with count-trailing-zeros. The quoted state carries across
+// blocks, so records and quoted fields may span any number of blocks.
+class CsvScanner {
+private:
+    std::string_view data;
+    size_t nextBlock = 0;     // offset of the next block to classify
+    size_t blockBase = 0;     // offset of the block in `structurals`
+    uint64_t structurals = 0; // unvisited structural bits of the current block
+    uint64_t quoteCarry = 0;  // all ones if the previous block ended inside quotes
+    size_t fieldStart = 0;
+    size_t recordStart = 0;
+    size_t recordEnd = 0;
+
+    static uint64_t prefixXor(uint64_t m) {
+        m ^= m << 1; m ^= m << 2; m ^= m << 4;
+        m ^= m << 8; m ^= m << 16; m ^= m << 32;
+        return m;
+    }
+
+    static int lowestBit(uint64_t m) {
+#if defined(__GNUC__)
+        return __builtin_ctzll(m);
+#else
+        int n = 0; while (!(m & 1)) { m >>= 1; ++n; } return n;
+#endif
+    }
+
+    // Bitmasks of '"', ',' and '\n' for 64 bytes at p
+    static void classify(const char* p, uint64_t& quotes, uint64_t& commas, uint64_t& newlines) {
+#ifdef CSV_SCANNER_SSE2
+        const __m128i q = _mm_set1_epi8('"'), c = _mm_set1_epi8(','), n = _mm_set1_epi8('\n');
+        quotes = commas = newlines = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+            quotes   |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)))) << (16 * i);
+            commas   |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, c)))) << (16 * i);
+            newlines |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, n)))) << (16 * i);
+        }
+#else
+        quotes = commas = newlines = 0;
+        for (int i = 0; i < 64; ++i) {
+            uint64_t bit = uint64_t(1) << i;
+            if (p[i] == '"') quotes |= bit;
+            else if (p[i] == ',') commas |= bit;
+            else if (p[i] == '\n') newlines |= bit;
+        }
+#endif
+    }
+
+    bool loadBlock() {
+        if (nextBlock >= data.size()) return false;
+        uint64_t quotes, commas, newlines;
+        size_t left = data.size() - nextBlock;
+        if (left >= 64) {
+            classify(data.data() + nextBlock, quotes, commas, newlines);
+        } else {
+            char tail[64] = {};
+            std::memcpy(tail, data.data() + nextBlock, left);
+            classify(tail, quotes, commas, newlines);
+        }
+        uint64_t inside = prefixXor(quotes) ^ quoteCarry;
+        quoteCarry = uint64_t(0) - (inside >> 63);
+        structurals = (commas | newlines) & ~inside;
+        blockBase = nextBlock;
+        nextBlock += 64;
+        return true;
+    }
+
+    std::string_view takeField(size_t end) {
+        std::string_view f(data.data() + fieldStart, end - fieldStart);
+        fieldStart = end + 1;
+        return f;
+    }
+
+    static bool isBlank(const CsvFields& fields) {
+        return fields.size() == 1 && fields[0].empty();
+    }
+
+    static void dropCR(CsvFields& fields) {
+        std::string_view& last = fields.back();
+        if (!last.empty() && last.back() == '\r') last.remove_suffix(1);
+    }
+
+public:
+    explicit CsvScanner(std::string_view input) : data(input) {}
+
+    // Fill fields with the raw views of the next record; false at end of input.
+    bool next(CsvFields& fields) {
+        fields.clear();
+        while (true) {
+            while (structurals == 0) {
+                if (!loadBlock()) {
+                    if (fieldStart >= data.size() && fields.empty()) return false;
+                    if (fields.empty()) recordStart = fieldStart;
+                    recordEnd = data.size();
+                    fields.push_back(takeField(data.size()));
+                    dropCR(fields);
+                    if (isBlank(fields)) { fields.clear(); return false; }
+                    return true;
+                }
+            }
+            size_t pos = blockBase + static_cast<size_t>(lowestBit(structurals));
+            structurals &= structurals - 1;
+            if (fields.empty()) recordStart = fieldStart;
+            fields.push_back(takeField(pos));
+            if (data[pos] == '\n') {
+                recordEnd = pos;
+                dropCR(fields);
+                if (isBlank(fields)) { fields.clear(); continue; }
+                return true;
+            }
+        }
+    }
+
+    // Raw text of the record last returned by next(), for diagnostics
+    std::string_view recordText() const { return data.substr(recordStart, recordEnd - recordStart); }
+};
+
+// Read a whole file into out (reusing its capacity). False if it cannot be opened.
+inline bool readWholeFile(const std::string& path, std::string& out) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    std::fseek(f, 0, SEEK_END);
+    long size = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+    out.resize(size > 0 ? static_cast<size_t>(size) : 0);
+    out.resize(std::fread(&out[0], 1, out.size(), f));
+    std::fclose(f);
+    return true;
+}
+
+#endif // CSV_SCANNER_H
@@ -0,0 +1,151 @@
+#ifndef DATE_TIME_H
+#define DATE_TIME_H
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+// ** Packed dates and times **
+// A Date is one 32-bit integer (year << 9 | month << 5 | day), so comparing
+// the integers compares the calendar dates and sorting or range-filtering
+// events never touches strings. A TimeOfDay is minutes since midnight.
+// Parsing and validation are constexpr and use real calendar rules (month
+// lengths, leap years), replacing the per-field substr/stoi checks.
+// Accepted text forms are YYYY-MM-DD (data files, test.cpp prompts) and
+// MM/DD/YYYY (final_project prompts); years are limited to 1900-2100.
+
+// Fixed-size text rendering of a date or time, e.g. "2025-10-20"
+struct DateText {
+    char text[11];
+    std::string_view view() const { return std::string_view(text); }
+    operator std::string_view() const { return view(); }
+    friend std::ostream& operator<<(std::ostream& os, const DateText& t) { return os << t.text; }
+};
+
+namespace date_detail {
+
+// Digit value, or something > 9 for a non-digit (no branch)
+constexpr unsigned digit(char c) { return static_cast<unsigned>(static_cast<unsigned char>(c)) - '0'; }
+
+template <typename... U>
+constexpr bool allDigits(U... v) { return ((v < 10) & ...); }
+
+constexpr bool isLeapYear(unsigned y) { return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0; }
+
+constexpr unsigned daysInMonth(unsigned y, unsigned m) {
+    return m == 2 ? 28 + isLeapYear(y) : 30 + ((m + (m >> 3)) & 1);
+}
+
+constexpr void put2(char* p, unsigned v) { p[0] = char('0' + v / 10); p[1] = char('0' + v % 10); }
+
+} // namespace date_detail
+
+struct Date {
+    uint32_t packed = 0; // 0 = no date
+
+    static constexpr uint32_t pack(unsigned y, unsigned m, unsigned d) { return (y << 9) | (m << 5) | d; }
+    static constexpr bool isValid(unsigned y, unsigned m, unsigned d) {
+        return (y >= 1900) & (y <= 2100) & (m >= 1) & (m <= 12) & (d >= 1) &
+               (d <= date_detail::daysInMonth(y, m));
+    }
+    // Builds a Date from components; the caller checks isValid() first.
+    static constexpr Date fromYmd(unsigned y, unsigned m, unsigned d) { Date r; r.packed = pack(y, m, d); return r; }
+
+    constexpr unsigned year() const { return packed >> 9; }
+    constexpr unsigned month() const { return (packed >> 5) & 0xF; }
+    constexpr unsigned day() const { return packed & 0x1F; }
+
+    DateText iso() const {
+        DateText t{};
+        unsigned y = year();
+        date_detail::put2(t.text, y / 100); date_detail::put2(t.text + 2, y % 100);
+        t.text[4] = '-'; date_detail::put2(t.text + 5, month());
+        t.text[7] = '-'; date_detail::put2(t.text + 8, day());
+        return t;
+    }
+    DateText us() const {
+        DateText t{};
+        unsigned y = year();
+        date_detail::put2(t.text, month()); t.text[2] = '/';
+        date_detail::put2(t.text + 3, day()); t.text[5] = '/';
+        date_detail::put2(t.text + 6, y / 100); date_detail::put2(t.text + 8, y % 100);
+        return t;
+    }
+
+    friend constexpr bool operator==(Date a, Date b) { return a.packed == b.packed; }
+    friend constexpr bool operator!=(Date a, Date b) { return a.packed != b.packed; }
+    friend constexpr bool operator<(Date a, Date b) { return a.packed < b.packed; }
+    friend constexpr bool operator<=(Date a, Date b) { return a.packed <= b.packed; }
+};
+
+struct TimeOfDay {
+    uint16_t minutes = 0; // Minutes since midnight
+
+    constexpr unsigned hour() const { return minutes / 60u; }
+    constexpr unsigned minute() const { return minutes % 60u; }
+
+    DateText hhmm() const {
+        DateText t{};
+        date_detail::put2(t.text, hour()); t.text[2] = ':'; date_detail::put2(t.text + 3, minute());
+        return t;
+    }
+
+    friend constexpr bool operator==(TimeOfDay a, TimeOfDay b) { return a.minutes == b.minutes; }
+    friend constexpr bool operator<(TimeOfDay a, TimeOfDay b) { return a.minutes < b.minutes; }
+};
+
+// 64-bit chronological sort key for an event's date and start time
+constexpr uint64_t dateTimeKey(Date d, TimeOfDay t) { return (uint64_t(d.packed) << 16) | t.minutes; }
+
+// YYYY-MM-DD
+constexpr bool parseIsoDate(std::string_view s, Date& out) {
+    if (s.size() != 10) return false;
+    using date_detail::digit;
+    unsigned y0 = digit(s[0]), y1 = digit(s[1]), y2 = digit(s[2]), y3 = digit(s[3]);
+    unsigned m0 = digit(s[5]), m1 = digit(s[6]), d0 = digit(s[8]), d1 = digit(s[9]);
+    bool ok = date_detail::allDigits(y0, y1, y2, y3, m0, m1, d0, d1) & (s[4] == '-') & (s[7] == '-');
+    unsigned y = y0 * 1000 + y1 * 100 + y2 * 10 + y3, m = m0 * 10 + m1, d = d0 * 10 + d1;
+    if (!(ok & Date::isValid(y, m, d))) return false;
+    out = Date::fromYmd(y, m, d);
+    return true;
+}
+
+// MM/DD/YYYY
+constexpr bool parseUsDate(std::string_view s, Date& out) {
+    if (s.size() != 10) return false;
+    using date_detail::digit;
+    unsigned m0 = digit(s[0]), m1 = digit(s[1]), d0 = digit(s[3]), d1 = digit(s[4]);
+    unsigned y0 = digit(s[6]), y1 = digit(s[7]), y2 = digit(s[8]), y3 = digit(s[9]);
+    bool ok = date_detail::allDigits(y0, y1, y2, y3, m0, m1, d0, d1) & (s[2] == '/') & (s[5] == '/');
+    unsigned y = y0 * 1000 + y1 * 100 + y2 * 10 + y3, m = m0 * 10 + m1, d = d0 * 10 + d1;
+    if (!(ok & Date::isValid(y, m, d))) return false;
+    out = Date::fromYmd(y, m, d);
+    return true;
+}
+
+// Either accepted form, told apart by the separator in position 4
+constexpr bool parseDate(std::string_view s, Date& out) {
+    return s.size() == 10 && (s[4] == '-' ? parseIsoDate(s, out) : parseUsDate(s, out));
+}
+
+// HH:MM, 24-hour
+constexpr bool parseTime(std::string_view s, TimeOfDay& out) {
+    if (s.size() != 5) return false;
+    using date_detail::digit;
+    unsigned h0 = digit(s[0]), h1 = digit(s[1]), m0 = digit(s[3]), m1 = digit(s[4]);
+    unsigned h = h0 * 10 + h1, m = m0 * 10 + m1;
+    if (!(date_detail::allDigits(h0, h1, m0, m1) & (s[2] == ':') & (h < 24) & (m < 60))) return false;
+    out.minutes = static_cast<uint16_t>(h * 60 + m);
+    return true;
+}
+
+// Compile-time literals for seed data, e.g. dateLiteral("2025-10-20")
+constexpr Date dateLiteral(std::string_view s) { Date d; parseDate(s, d); return d; }
+constexpr TimeOfDay timeLiteral(std::string_view s) { TimeOfDay t; parseTime(s, t); return t; }
+
+static_assert([] { Date d; return parseIsoDate("2024-02-29", d) && d.year() == 2024 && d.day() == 29; }(),
+              "leap day accepted");
+static_assert([] { Date d; return !parseIsoDate("2023-02-29", d) && !parseUsDate("02/31/2025", d); }(),
+              "impossible days rejected");
+
+#endif // DATE_TIME_H
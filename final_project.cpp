@@ -3,6 +3,25 @@
 #include <cstdlib>
 #include <ctime>
 #include <limits>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "output_buffer.h"
+#include "command_script.h"
+#include "date_time.h"
+#include "scratch_arena.h"
+#include "id_list.h"
+#include "bench_harness.h"
+#include "session_replay.h"
+#ifdef EMS_ALLOC_PROFILE
+#include "alloc_counter.h" // Opt-in: per-operation heap counts in the latency report
+#endif
+#include "latency_histogram.h"
+#include "trace_spans.h"
+#include "sampling_profiler.h"
+#include "slow_log.h"
+#include "audit_log.h"
+#include <sstream>
 
 using namespace std;
 
@@ -11,10 +30,19 @@ class User;
 class Event;
 
 // Constants
-const int MAX_USERS = 100;
-const int MAX_EVENTS = 100;
 const int MAX_STR_LEN = 100;
 
+// Latency histogram operations ("latency" batch command, latency.txt at exit)
+const int OP_FIND_USER = LatencyStats::operation("find-user");
+const int OP_FIND_EVENT = LatencyStats::operation("find-event");
+const int OP_ADD_USER = LatencyStats::operation("add-user");
+const int OP_ADD_EVENT = LatencyStats::operation("add-event");
+const int OP_DELETE_EVENT = LatencyStats::operation("delete-event");
+const int OP_REGISTER_EVENT = LatencyStats::operation("register-event");
+const int OP_LIST_EVENTS = LatencyStats::operation("list-events");
+const int OP_LIST_USERS = LatencyStats::operation("list-users");
+const int OP_MY_EVENTS = LatencyStats::operation("my-events");
+
 // Exception classes
 class ValidationException : public exception {
 private:
@@ -161,44 +189,34 @@ private:
     int id;
     char name[MAX_STR_LEN];
     char description[MAX_STR_LEN];
-    char date[MAX_STR_LEN];
-    char time[MAX_STR_LEN];
+    Date date;       // Packed; MM/DD/YYYY only at input and display
+    TimeOfDay time;
     int capacity;
-    int registeredUsers[MAX_USERS];
-    int registeredCount;
+    IdList registeredUsers; // Sorted user IDs, delta-varint encoded; no fixed cap
 
 public:
-    Event() : id(0), capacity(0), registeredCount(0) {
+    Event() : id(0), capacity(0) {
         strcpy(name, "");
         strcpy(description, "");
-        strcpy(date, "");
-        strcpy(time, "");
-        for (int i = 0; i < MAX_USERS; i++) {
-            registeredUsers[i] = 0;
-        }
     }
 
-    Event(const char* evtName, const char* desc, const char* evtDate, const char* evtTime, int cap) 
-        : registeredCount(0) {
+    Event(const char* evtName, const char* desc, const char* evtDate, const char* evtTime, int cap) {
         setId(rand() % 9000 + 1000); // Generate random ID between 1000-9999
         setName(evtName);
         setDescription(desc);
         setDate(evtDate);
         setTime(evtTime);
         setCapacity(cap);
-        for (int i = 0; i < MAX_USERS; i++) {
-            registeredUsers[i] = 0;
-        }
     }
 
     // Getters
     int getId() const { return id; }
     const char* getName() const { return name; }
     const char* getDescription() const { return description; }
-    const char* getDate() const { return date; }
-    const char* getTime() const { return time; }
+    Date getDate() const { return date; }
+    TimeOfDay getTime() const { return time; }
     int getCapacity() const { return capacity; }
-    int getRegisteredCount() const { return registeredCount; }
+    int getRegisteredCount() const { return static_cast<int>(registeredUsers.size()); }
 
     // Setters with validation
     void setId(int newId) {
@@ -223,19 +241,17 @@ public:
     }
 
     void setDate(const char* evtDate) {
-        // Simple date format validation (MM/DD/YYYY)
-        if (strlen(evtDate) != 10 || evtDate[2] != '/' || evtDate[5] != '/') {
-            throw ValidationException("Date must be in MM/DD/YYYY format");
+        // Real calendar validation (MM/DD/YYYY; YYYY-MM-DD is accepted too)
+        if (!parseDate(evtDate, date)) {
+            throw ValidationException("Date must be a valid date in MM/DD/YYYY format");
         }
-        strcpy(date, evtDate);
     }
 
     void setTime(const char* evtTime) {
-        // Simple time format validation (HH:MM)
-        if (strlen(evtTime) != 5 || evtTime[2] != ':') {
+        // 24-hour time validation (HH:MM)
+        if (!parseTime(evtTime, time)) {
             throw ValidationException("Time must be in HH:MM format");
         }
-        strcpy(time, evtTime);
     }
 
     void setCapacity(int cap) {
@@ -247,40 +263,38 @@ public:
 
     // Register a user for this event
     bool registerUser(int userId) {
-        if (registeredCount >= capacity) {
+        LatencyScope timer(OP_REGISTER_EVENT);
+        TraceSpan span("registerUser", "registration");
+        SlowOp slow("registerUser");
+        slow.count("eventId", id);
+        slow.count("userId", userId);
+        slow.count("registered", getRegisteredCount());
+        if (getRegisteredCount() >= capacity) {
             return false; // Event is full
         }
         
-        // Check if user is already registered
-        for (int i = 0; i < registeredCount; i++) {
-            if (registeredUsers[i] == userId) {
-                return false;
-            }
+        // False if the user is already registered
+        if (!registeredUsers.insert(userId)) {
+            return false;
         }
-        
-        registeredUsers[registeredCount++] = userId;
+        AuditLog::record(AuditType::Registered, id, userId);
         return true;
     }
 
     // Check if a user is registered for this event
     bool isUserRegistered(int userId) const {
-        for (int i = 0; i < registeredCount; i++) {
-            if (registeredUsers[i] == userId) {
-                return true;
-            }
-        }
-        return false;
+        return registeredUsers.contains(userId);
     }
 
-    // Display event details
-    void display() const {
-        cout << "\nEvent ID: " << id << "\n";
-        cout << "Name: " << name << "\n";
-        cout << "Description: " << description << "\n";
-        cout << "Date: " << date << "\n";
-        cout << "Time: " << time << "\n";
-        cout << "Capacity: " << capacity << "\n";
-        cout << "Registered: " << registeredCount << "\n";
+    // Render event details into a page buffer
+    void display(OutputBuffer& out) const {
+        out << "\nEvent ID: " << id << "\n"
+            << "Name: " << name << "\n"
+            << "Description: " << description << "\n"
+            << "Date: " << date.us().view() << "\n"
+            << "Time: " << time.hhmm().view() << "\n"
+            << "Capacity: " << capacity << "\n"
+            << "Registered: " << getRegisteredCount() << "\n";
     }
 };
 
@@ -288,13 +302,11 @@ public:
 class Database {
 private:
     static Database* instance;
-    User* users[MAX_USERS];
-    Event* events[MAX_EVENTS];
-    int userCount;
-    int eventCount;
+    vector<User*> users;   // Grow as needed (were fixed arrays of 100)
+    vector<Event*> events;
 
     // Private constructor for singleton
-    Database() : userCount(0), eventCount(0) {
+    Database() {
         // Initialize with some default data
         addUser(new Admin("admin", "admin123"));
         addUser(new RegularUser("user1", "user123"));
@@ -302,11 +314,10 @@ private:
         
         time_t now = time(0);
         tm* ltm = localtime(&now);
-        char date[11];
-        sprintf(date, "%02d/%02d/%04d", 1 + ltm->tm_mon, ltm->tm_mday, 1900 + ltm->tm_year);
+        DateText date = Date::fromYmd(1900 + ltm->tm_year, 1 + ltm->tm_mon, ltm->tm_mday).us();
         
-        addEvent(new Event("Tech Conference", "Annual technology conference", date, "09:00", 100));
-        addEvent(new Event("Music Festival", "Summer music festival", date, "18:00", 500));
+        addEvent(new Event("Tech Conference", "Annual technology conference", date.text, "09:00", 100));
+        addEvent(new Event("Music Festival", "Summer music festival", date.text, "18:00", 500));
     }
 
 public:
@@ -320,23 +331,28 @@ public:
 
     // Add a user to the database
     void addUser(User* user) {
-        if (userCount >= MAX_USERS) {
-            throw DatabaseException("Maximum user capacity reached");
-        }
-        users[userCount++] = user;
+        LatencyScope timer(OP_ADD_USER);
+        TraceSpan span("addUser", "db");
+        users.push_back(user);
+        AuditLog::record(AuditType::UserCreated, user->getId(), strcmp(user->getRole(), "admin") == 0, 0, user->getUsername());
     }
 
     // Add an event to the database
     void addEvent(Event* event) {
-        if (eventCount >= MAX_EVENTS) {
-            throw DatabaseException("Maximum event capacity reached");
-        }
-        events[eventCount++] = event;
+        LatencyScope timer(OP_ADD_EVENT);
+        TraceSpan span("addEvent", "db");
+        events.push_back(event);
+        AuditLog::record(AuditType::EventCreated, event->getId(), 0, 0, event->getName());
     }
 
     // Find user by username
     User* findUserByUsername(const char* username) {
-        for (int i = 0; i < userCount; i++) {
+        LatencyScope timer(OP_FIND_USER);
+        TraceSpan span("findUserByUsername", "db");
+        SlowOp slow("findUserByUsername");
+        slow.text("user", username);
+        slow.count("users", static_cast<int64_t>(users.size()));
+        for (size_t i = 0; i < users.size(); i++) {
             if (strcmp(users[i]->getUsername(), username) == 0) {
                 return users[i];
             }
@@ -346,7 +362,9 @@ public:
 
     // Find event by ID
     Event* findEventById(int id) {
-        for (int i = 0; i < eventCount; i++) {
+        LatencyScope timer(OP_FIND_EVENT);
+        TraceSpan span("findEventById", "db");
+        for (size_t i = 0; i < events.size(); i++) {
             if (events[i]->getId() == id) {
                 return events[i];
             }
@@ -355,23 +373,27 @@ public:
     }
 
     // Get all users
-    User** getAllUsers() { return users; }
-    int getUserCount() const { return userCount; }
+    User** getAllUsers() { return users.data(); }
+    int getUserCount() const { return static_cast<int>(users.size()); }
 
     // Get all events
-    Event** getAllEvents() { return events; }
-    int getEventCount() const { return eventCount; }
+    Event** getAllEvents() { return events.data(); }
+    int getEventCount() const { return static_cast<int>(events.size()); }
 
     // Delete an event
     bool deleteEvent(int id) {
-        for (int i = 0; i < eventCount; i++) {
+        LatencyScope timer(OP_DELETE_EVENT);
+        TraceSpan span("deleteEvent", "db");
+        SlowOp slow("deleteEvent");
+        slow.count("eventId", id);
+        slow.count("events", static_cast<int64_t>(events.size()));
+        for (size_t i = 0; i < events.size(); i++) {
             if (events[i]->getId() == id) {
+                slow.phase("find");
+                AuditLog::record(AuditType::EventDeleted, id);
                 delete events[i];
-                // Shift remaining elements
-                for (int j = i; j < eventCount - 1; j++) {
-                    events[j] = events[j + 1];
-                }
-                eventCount--;
+                events.erase(events.begin() + i);
+                slow.phase("erase");
                 return true;
             }
         }
@@ -547,7 +569,109 @@ bool getYesNoInput() {
 
 // Main application
 class EventManagementSystem {
+private:
+    OutputBuffer page; // Reused for every listing; emitted with one write per page
+    User* scriptUser = nullptr; // Logged-in user while running a batch script
+    ScratchArena scratch; // C-string copies of command arguments, released per command
+
+    void showEvent(const Event* event) {
+        event->display(page);
+        page.flushTo(cout);
+    }
+
 public:
+// Batch mode: one command per line, no prompts.
+//   login <user> <pass> | logout | register <user> <pass> <admin|user>
+//   create-event <name> <description> <MM/DD/YYYY> <HH:MM> <capacity>
+//   update-event <id> <name|description|date|time|capacity> <value>
+//   delete-event <id> | list-events | list-users | join-event <id> | my-events
+//   latency (admin: p50/p99/p99.9/max per operation)
+//   trace on|off | trace save <file.json> (admin: Chrome trace of the spans so far)
+//   profile start [hz] | profile stop <file.folded> (admin: CPU samples as folded stacks)
+//   slow-log <ms>[,<op>=<ms>]... | slow-log off (admin: log operations slower than this)
+int runScript(istream& in) {
+    return runCommandScript(in, [this](const CommandLine& cmd) { return executeCommand(cmd); });
+}
+
+// Benchmarks (--bench [max-size]): grows the in-memory database to each size
+// in turn (10^2 up to max-size users and events) and times lookups,
+// registration and listings at that size. Results go to stdout as CSV.
+int runBenchmarks(size_t maxSize) {
+    Database* db = Database::getInstance();
+    ostream results(cout.rdbuf());
+    NullStreamBuf sink;
+    streambuf* realOut = cout.rdbuf(&sink); // Listings under benchmark
+    BenchRunner bench(results, "final_project");
+    vector<string> names;
+    vector<int> eventIds;
+    for (size_t n : benchSizes(maxSize)) {
+        while (names.size() < n) {
+            size_t i = names.size();
+            names.push_back("bench" + to_string(i));
+            db->addUser(new RegularUser(names.back().c_str(), "password1"));
+            Event* event = new Event(("Event " + to_string(i)).c_str(), "Synthetic event", "01/15/2025", "09:00", 1000);
+            event->setId(static_cast<int>(10000 + i)); // Unique, unlike the random interactive IDs
+            if (i % 10 == 0) event->registerUser(db->getAllUsers()[0]->getId());
+            db->addEvent(event);
+            eventIds.push_back(event->getId());
+        }
+        size_t k = 0;
+        bench.run("findUserByUsername", n, [&] { doNotOptimize(db->findUserByUsername(names[k++ % n].c_str())); });
+        bench.run("findEventById", n, [&] { doNotOptimize(db->findEventById(eventIds[(k++ * 7919) % n])); });
+        Event big("Big Event", "Registration target", "01/15/2025", "09:00", 1 << 30);
+        int nextUser = 1;
+        bench.run("Event::registerUser", n, [&] { doNotOptimize(big.registerUser(nextUser++)); });
+        bench.run("Event::isUserRegistered", n, [&] { doNotOptimize(big.isUserRegistered(static_cast<int>(k++ % nextUser))); });
+        bench.run("viewAllUsers", n, [&] { viewAllUsers(db); });
+        bench.run("viewAllEvents", n, [&] { viewAllEvents(); });
+        bench.run("viewUserEvents", n, [&] { viewUserEvents(db->getAllUsers()[0]); });
+    }
+    cout.rdbuf(realOut);
+    return 0;
+}
+
+// Session replay (--replay [session|-|builtin] [repeat]): feeds a session
+// (see session_replay.h) to run() repeat times (default 20) and reports
+// per-operation timings as CSV. The database is in memory and shared by all
+// repetitions, so events created by a session accumulate.
+int runReplay(const string& path, int repeat) {
+    static const char builtinSession[] =
+        "@login-admin\n1\nadmin\nadmin123\n"
+        "@view-events\n2\n"
+        "@view-users\n5\n"
+        "@create-event\n1\nReplay Meetup\nSession replay event\n01/15/2025\n10:00\n50\n"
+        "@logout\n6\n"
+        "@login-user\n1\nuser1\nuser123\n"
+        "@view-events\n1\n"
+        "@register-unknown\n2\n9999\n"
+        "@my-events\n3\n"
+        "@logout\n4\n";
+    ReplaySession session;
+    if (path == "-") {
+        session = ReplaySession::parse(cin);
+    } else if (path == "builtin") {
+        istringstream in(builtinSession);
+        session = ReplaySession::parse(in);
+    } else {
+        ifstream in(path);
+        if (!in) {
+            cerr << "Cannot open session '" << path << "'.\n";
+            return 1;
+        }
+        session = ReplaySession::parse(in);
+    }
+    SessionReplayer replayer(session);
+    for (int r = 0; r < repeat; ++r) {
+        size_t unread = replayer.run([this] { run(); });
+        if (unread && r == 0) {
+            cerr << "Warning: the menus stopped with " << unread << " session lines unread.\n";
+        }
+    }
+    ostream results(cout.rdbuf());
+    replayer.report(results, "final_project");
+    return 0;
+}
+
 void run() {
     cout << "Event Management System\n";
     
@@ -557,6 +681,7 @@ void run() {
         if (!currentUser) {
             currentUser = showAuthMenu();
             if (!currentUser) continue;
+            AuditLog::setActor(currentUser->getId());
         }
         
         try {
@@ -569,16 +694,194 @@ void run() {
             // After logout, reset currentUser to show auth menu again
             if (!currentUser->getIsLoggedIn()) {
                 currentUser = nullptr;
+                AuditLog::setActor(0);
             }
         } catch (const exception& e) {
             cout << "Error: " << e.what() << "\n";
             // On error, reset to auth menu
             currentUser = nullptr;
+            AuditLog::setActor(0);
         }
     }
 }
     
 private:
+void requireScriptUser(bool admin) {
+    if (!scriptUser) {
+        throw AuthException("Login required");
+    }
+    if (admin && strcmp(scriptUser->getRole(), "admin") != 0) {
+        throw AuthException("Admin login required");
+    }
+}
+
+Event* requireEvent(const CommandLine& cmd, size_t index) {
+    int id;
+    if (!cmd.getInt(index, id)) {
+        throw ValidationException("Event ID must be a number");
+    }
+    Event* event = Database::getInstance()->findEventById(id);
+    if (!event) {
+        throw DatabaseException("Event not found");
+    }
+    return event;
+}
+
+bool executeCommand(const CommandLine& cmd) {
+    ScratchArena::Scope request(scratch);
+    Database* db = Database::getInstance();
+    string_view op = cmd[0];
+    size_t argc = cmd.size() - 1;
+    
+    if (op == "login" && argc == 2) {
+        const char* uname = scratch.cstr(cmd[1]);
+        const char* pwd = scratch.cstr(cmd[2]);
+        User* user = db->findUserByUsername(uname);
+        if (!user || !user->login(uname, pwd)) {
+            throw AuthException("Invalid username or password");
+        }
+        scriptUser = user;
+        AuditLog::setActor(user->getId());
+        cout << "Logged in as " << user->getUsername() << ".\n";
+        return true;
+    }
+    if (op == "logout" && argc == 0) {
+        requireScriptUser(false);
+        scriptUser->logout();
+        scriptUser = nullptr;
+        AuditLog::setActor(0);
+        return true;
+    }
+    if (op == "register" && argc == 3) {
+        const char* uname = scratch.cstr(cmd[1]);
+        const char* pwd = scratch.cstr(cmd[2]);
+        if (db->findUserByUsername(uname)) {
+            throw ValidationException("Username already exists");
+        }
+        User* newUser;
+        if (cmd[3] == "admin") {
+            newUser = new Admin(uname, pwd);
+        } else if (cmd[3] == "user") {
+            newUser = new RegularUser(uname, pwd);
+        } else {
+            throw ValidationException("Role must be either 'admin' or 'user'");
+        }
+        db->addUser(newUser);
+        newUser->login(uname, pwd);
+        scriptUser = newUser;
+        AuditLog::setActor(newUser->getId());
+        cout << "Registered " << newUser->getUsername() << " (ID: " << newUser->getId() << ").\n";
+        return true;
+    }
+    if (op == "create-event" && argc == 5) {
+        requireScriptUser(true);
+        int capacity;
+        if (!cmd.getInt(5, capacity)) {
+            throw ValidationException("Capacity must be a number");
+        }
+        Event* newEvent = new Event(scratch.cstr(cmd[1]), scratch.cstr(cmd[2]), scratch.cstr(cmd[3]),
+                                    scratch.cstr(cmd[4]), capacity);
+        db->addEvent(newEvent);
+        cout << "Event created (ID: " << newEvent->getId() << ").\n";
+        return true;
+    }
+    if (op == "update-event" && argc == 3) {
+        requireScriptUser(true);
+        Event* event = requireEvent(cmd, 1);
+        const char* value = scratch.cstr(cmd[3]);
+        string_view field = cmd[2];
+        if (field == "name") event->setName(value);
+        else if (field == "description") event->setDescription(value);
+        else if (field == "date") event->setDate(value);
+        else if (field == "time") event->setTime(value);
+        else if (field == "capacity") {
+            int capacity;
+            if (!cmd.getInt(3, capacity)) {
+                throw ValidationException("Capacity must be a number");
+            }
+            event->setCapacity(capacity);
+        }
+        else return false;
+        AuditLog::record(AuditType::EventEdited, event->getId(), 0, 0, field);
+        return true;
+    }
+    if (op == "delete-event" && argc == 1) {
+        requireScriptUser(true);
+        db->deleteEvent(requireEvent(cmd, 1)->getId());
+        return true;
+    }
+    if (op == "list-events" && argc == 0) {
+        requireScriptUser(false);
+        viewAllEvents();
+        return true;
+    }
+    if (op == "list-users" && argc == 0) {
+        requireScriptUser(true);
+        viewAllUsers(db);
+        return true;
+    }
+    if (op == "join-event" && argc == 1) {
+        requireScriptUser(false);
+        Event* event = requireEvent(cmd, 1);
+        if (!event->registerUser(scriptUser->getId())) {
+            throw ValidationException("Already registered or event is full");
+        }
+        return true;
+    }
+    if (op == "latency" && argc == 0) {
+        requireScriptUser(true);
+        LatencyStats::report(cout);
+        return true;
+    }
+    if (op == "trace" && argc == 1 && (cmd[1] == "on" || cmd[1] == "off")) {
+        requireScriptUser(true);
+        Tracer::enable(cmd[1] == "on");
+        return true;
+    }
+    if (op == "trace" && argc == 2 && cmd[1] == "save") {
+        requireScriptUser(true);
+        size_t spans = 0;
+        if (!Tracer::writeChromeJson(cmd.str(2), &spans)) {
+            throw DatabaseException("Cannot write trace file");
+        }
+        cout << "Wrote " << spans << " spans to " << cmd[2] << ".\n";
+        return true;
+    }
+    if (op == "profile" && (argc == 1 || argc == 2) && cmd[1] == "start") {
+        requireScriptUser(true);
+        int hz = 99;
+        if (argc == 2 && !cmd.getInt(2, hz)) {
+            throw ValidationException("Sampling rate must be a number");
+        }
+        if (!SamplingProfiler::start(hz)) {
+            throw DatabaseException("Profiler already running or unsupported here");
+        }
+        return true;
+    }
+    if (op == "profile" && argc == 2 && cmd[1] == "stop") {
+        requireScriptUser(true);
+        if (!SamplingProfiler::running()) {
+            throw DatabaseException("Profiler is not running");
+        }
+        size_t samples = SamplingProfiler::stop(cmd.str(2));
+        cout << "Wrote " << samples << " samples to " << cmd[2] << ".\n";
+        return true;
+    }
+    if (op == "slow-log" && argc == 1) {
+        requireScriptUser(true);
+        if (!SlowLog::configure(cmd[1])) {
+            throw ValidationException("Expected <ms>[,<op>=<ms>]... or off");
+        }
+        return true;
+    }
+    if (op == "my-events" && argc == 0) {
+        requireScriptUser(false);
+        viewUserEvents(scriptUser);
+        return true;
+    }
+    return false;
+}
+
 User* showAuthMenu() {
     while (true) {  // Keep showing menu until valid choice or exit
         cout << "\nEvent Management System\n";
@@ -738,24 +1041,26 @@ User* showAuthMenu() {
         db->addEvent(newEvent);
         
         cout << "Event created successfully!\n";
-        newEvent->display();
+        showEvent(newEvent);
     }
     
     void viewAllEvents() {
+        LatencyScope timer(OP_LIST_EVENTS);
+        TraceSpan span("viewAllEvents", "report");
         Database* db = Database::getInstance();
         Event** events = db->getAllEvents();
         int count = db->getEventCount();
         
-        cout << "\nAll Events (" << count << ")\n";
+        page << "\nAll Events (" << count << ")\n";
         
         if (count == 0) {
-            cout << "No events found.\n";
-            return;
+            page << "No events found.\n";
         }
         
         for (int i = 0; i < count; i++) {
-            events[i]->display();
+            events[i]->display(page);
         }
+        page.flushTo(cout);
     }
     
     void updateEvent() {
@@ -772,7 +1077,7 @@ User* showAuthMenu() {
         }
         
         cout << "Current event details:\n";
-        event->display();
+        showEvent(event);
         
         char name[MAX_STR_LEN];
         char description[MAX_STR_LEN];
@@ -788,6 +1093,7 @@ User* showAuthMenu() {
                     cout << "New name: ";
                     cin.getline(name, MAX_STR_LEN);
                     event->setName(name);
+                    AuditLog::record(AuditType::EventEdited, event->getId(), 0, 0, "name");
                     break;
                 } catch (const ValidationException& e) {
                     cout << "Error: " << e.what() << "\n";
@@ -803,6 +1109,7 @@ User* showAuthMenu() {
                     cout << "New description: ";
                     cin.getline(description, MAX_STR_LEN);
                     event->setDescription(description);
+                    AuditLog::record(AuditType::EventEdited, event->getId(), 0, 0, "description");
                     break;
                 } catch (const ValidationException& e) {
                     cout << "Error: " << e.what() << "\n";
@@ -811,13 +1118,14 @@ User* showAuthMenu() {
         }
         
         // Update date
-        cout << "Update date? Current: " << event->getDate() << "\n";
+        cout << "Update date? Current: " << event->getDate().us() << "\n";
         if (getYesNoInput()) {
             while (true) {
                 try {
                     cout << "New date (MM/DD/YYYY): ";
                     cin.getline(date, MAX_STR_LEN);
                     event->setDate(date);
+                    AuditLog::record(AuditType::EventEdited, event->getId(), 0, 0, "date");
                     break;
                 } catch (const ValidationException& e) {
                     cout << "Error: " << e.what() << "\n";
@@ -826,13 +1134,14 @@ User* showAuthMenu() {
         }
         
         // Update time
-        cout << "Update time? Current: " << event->getTime() << "\n";
+        cout << "Update time? Current: " << event->getTime().hhmm() << "\n";
         if (getYesNoInput()) {
             while (true) {
                 try {
                     cout << "New time (HH:MM): ";
                     cin.getline(time, MAX_STR_LEN);
                     event->setTime(time);
+                    AuditLog::record(AuditType::EventEdited, event->getId(), 0, 0, "time");
                     break;
                 } catch (const ValidationException& e) {
                     cout << "Error: " << e.what() << "\n";
@@ -848,6 +1157,7 @@ User* showAuthMenu() {
                     cout << "New capacity: ";
                     capacity = getNumericInput(1, 10000);
                     event->setCapacity(capacity);
+                    AuditLog::record(AuditType::EventEdited, event->getId(), 0, 0, "capacity");
                     break;
                 } catch (const ValidationException& e) {
                     cout << "Error: " << e.what() << "\n";
@@ -856,7 +1166,7 @@ User* showAuthMenu() {
         }
         
         cout << "Event updated successfully!\n";
-        event->display();
+        showEvent(event);
     }
     
     void deleteEvent() {
@@ -873,7 +1183,7 @@ User* showAuthMenu() {
         }
         
         cout << "You are about to delete this event:\n";
-        event->display();
+        showEvent(event);
         cout << "Are you sure you want to delete this event?\n";
         
         if (getYesNoInput()) {
@@ -888,21 +1198,23 @@ User* showAuthMenu() {
     }
     
     void viewAllUsers(Database* db) {
+        LatencyScope timer(OP_LIST_USERS);
+        TraceSpan span("viewAllUsers", "report");
         User** users = db->getAllUsers();
         int count = db->getUserCount();
         
-        cout << "\nAll Users (" << count << ")\n";
+        page << "\nAll Users (" << count << ")\n";
         
         if (count == 0) {
-            cout << "No users found.\n";
-            return;
+            page << "No users found.\n";
         }
         
         for (int i = 0; i < count; i++) {
-            cout << "\nUser ID: " << users[i]->getId() << "\n";
-            cout << "Username: " << users[i]->getUsername() << "\n";
-            cout << "Role: " << users[i]->getRole() << "\n";
+            page << "\nUser ID: " << users[i]->getId() << "\n"
+                 << "Username: " << users[i]->getUsername() << "\n"
+                 << "Role: " << users[i]->getRole() << "\n";
         }
+        page.flushTo(cout);
     }
     
     void registerForEvent(User* user) {
@@ -931,31 +1243,72 @@ User* showAuthMenu() {
     }
     
     void viewUserEvents(User* user) {
+        LatencyScope timer(OP_MY_EVENTS);
+        TraceSpan span("viewUserEvents", "report");
         Database* db = Database::getInstance();
         Event** events = db->getAllEvents();
         int count = db->getEventCount();
         int userId = user->getId();
         bool found = false;
         
-        cout << "\nYour Registered Events\n";
+        page << "\nYour Registered Events\n";
         
         for (int i = 0; i < count; i++) {
             if (events[i]->isUserRegistered(userId)) {
-                events[i]->display();
+                events[i]->display(page);
                 found = true;
             }
         }
         
         if (!found) {
-            cout << "You are not registered for any events.\n";
+            page << "You are not registered for any events.\n";
         }
+        page.flushTo(cout);
     }
 };
 
-int main() {
+// Usage: final_project [--batch [script|-] | --bench [max-size] | --replay [session|-|builtin] [repeat]
+//                      | --audit-decode <file>]
+//        (batch mode reads stdin when no script is given)
+int main(int argc, char* argv[]) {
     srand(time(0)); // Seed for random ID generation
     
+    Tracer::enableFromEnvironment(); // EMS_TRACE=<file>
+    PerfCounters::enableFromEnvironment(); // EMS_PERF=1
+    SamplingProfiler::enableSignalToggle(); // EMS_PROFILE_SIGNAL=1: kill -USR2 <pid> starts/stops a profile
+    SamplingProfiler::enableFromEnvironment(); // EMS_PROFILE=<file>
+    SlowLog::configureFromEnvironment(); // EMS_SLOW_MS=<ms>, EMS_SLOW_LOG=<file>
+    if (argc >= 3 && strcmp(argv[1], "--audit-decode") == 0) {
+        ifstream log(argv[2], ios::binary);
+        if (!log) {
+            cerr << "Cannot open '" << argv[2] << "'.\n";
+            return 1;
+        }
+        AuditLog::decode(log, cout);
+        return 0;
+    }
     EventManagementSystem app;
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        return app.runBenchmarks(benchMaxSize(argc, argv, 2));
+    }
+    if (argc >= 2 && strcmp(argv[1], "--replay") == 0) {
+        return app.runReplay(argc >= 3 ? argv[2] : "builtin", argc >= 4 ? atoi(argv[3]) : 20);
+    }
+    atexit([] { LatencyStats::dump("latency.txt"); }); // Also runs on the menu's exit(0)
+    Database::getInstance(); // Seed data first, so only real changes are audited
+    AuditLog::openFromEnvironment(nullptr); // Nothing is persisted here, so only with EMS_AUDIT=<file>
+    if (argc >= 2 && strcmp(argv[1], "--batch") == 0) {
+        const char* path = argc >= 3 ? argv[2] : "-";
+        if (strcmp(path, "-") == 0) {
+            return app.runScript(cin) == 0 ? 0 : 1;
+        }
+        ifstream script(path);
+        if (!script) {
+            cerr << "Cannot open script '" << path << "'.\n";
+            return 1;
+        }
+        return app.runScript(script) == 0 ? 0 : 1;
+    }
     app.run();
     
     return 0;
@@ -0,0 +1,254 @@
+#ifndef ID_LIST_H
+#define ID_LIST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ID_LIST_SSE2 1
+#endif
+
+// ** IdList **
+// Sorted set of non-negative IDs (attendees of an event, registrations),
+// stored as the differences between consecutive IDs, each written as a
+// LEB128 varint: 7 bits per byte, high bit set on all but the last byte.
+// IDs handed out in order differ by small amounts, so most take one byte
+// instead of 4 in a vector<int> or ~6 as decimal text.
+// Decoding checks 16 bytes at a time (SSE2): when none has the continuation
+// bit set they are 16 one-byte deltas, turned back into IDs with a vector
+// prefix sum. A skip entry every 128 IDs (byte offset + the ID before it)
+// lets contains() decode one block instead of the whole list.
+// Appending an ID larger than the current maximum is O(1); inserting below
+// it or erasing re-encodes the list, which is fine for registration lists
+// that are mostly appended to and read.
+class IdList {
+private:
+    static constexpr uint32_t kSkipEvery = 128;
+
+    struct Skip {
+        uint32_t offset; // byte offset of ID number k * kSkipEvery
+        uint32_t before; // the ID preceding it (0 for the first block)
+    };
+
+    std::string bytes;
+    std::vector<Skip> skips;
+    uint32_t count = 0;
+    uint32_t last = 0;
+
+    static int lowestBit(uint32_t m) {
+#if defined(__GNUC__)
+        return __builtin_ctz(m);
+#else
+        int n = 0; while (!(m & 1)) { m >>= 1; ++n; } return n;
+#endif
+    }
+
+    static bool readVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+        v = 0;
+        for (int shift = 0; p < end && shift < 35; shift += 7) {
+            uint8_t b = *p++;
+            v |= uint32_t(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    void appendVarint(uint32_t v) {
+        while (v >= 0x80) { bytes.push_back(char(v | 0x80)); v >>= 7; }
+        bytes.push_back(char(v));
+    }
+
+    void appendUnchecked(uint32_t id) {
+        if (count % kSkipEvery == 0) skips.push_back({static_cast<uint32_t>(bytes.size()), last});
+        appendVarint(id - last);
+        last = id;
+        ++count;
+    }
+
+    // Decodes IDs from byte offset `from` (prev = the ID before it), calling
+    // f(id) until it returns false or the list ends.
+    template <typename F>
+    void decodeFrom(size_t from, uint32_t prev, F&& f) const {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(bytes.data()) + from;
+        const uint8_t* end = reinterpret_cast<const uint8_t*>(bytes.data()) + bytes.size();
+        while (p < end) {
+            int singles = 1; // one-byte varints before the next multi-byte one (+1 for it)
+#ifdef ID_LIST_SSE2
+            if (end - p >= 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                uint32_t cont = static_cast<uint32_t>(_mm_movemask_epi8(v));
+                if (cont == 0) {
+                    alignas(16) uint32_t ids[16];
+                    const __m128i zero = _mm_setzero_si128();
+                    __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+                    __m128i lanes[4] = { _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+                                         _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero) };
+                    __m128i base = _mm_set1_epi32(static_cast<int>(prev));
+                    for (int i = 0; i < 4; ++i) {
+                        __m128i x = lanes[i];
+                        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+                        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+                        x = _mm_add_epi32(x, base);
+                        _mm_store_si128(reinterpret_cast<__m128i*>(ids + 4 * i), x);
+                        base = _mm_shuffle_epi32(x, 0xFF);
+                    }
+                    for (uint32_t id : ids) if (!f(id)) return;
+                    prev = ids[15];
+                    p += 16;
+                    continue;
+                }
+                singles = lowestBit(cont) + 1;
+            }
+#endif
+            for (int i = 0; i < singles; ++i) {
+                uint32_t delta;
+                if (!readVarint(p, end, delta)) return;
+                prev += delta;
+                if (!f(prev)) return;
+            }
+        }
+    }
+
+    void assignSorted(const std::vector<uint32_t>& ids) {
+        clear();
+        for (uint32_t id : ids) appendUnchecked(id);
+    }
+
+public:
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { bytes.clear(); skips.clear(); count = 0; last = 0; }
+
+    // The delta-varint stream (what the binary and text codecs store)
+    std::string_view encoded() const { return bytes; }
+    size_t memoryBytes() const { return bytes.capacity() + skips.capacity() * sizeof(Skip); }
+
+    bool contains(int id) const {
+        if (count == 0 || id < 0 || static_cast<uint32_t>(id) > last) return false;
+        uint32_t target = static_cast<uint32_t>(id);
+        // Last block whose preceding ID is below the target
+        auto it = std::partition_point(skips.begin() + 1, skips.end(), [&](const Skip& s) { return s.before < target; });
+        const Skip& s = *(it - 1);
+        bool found = false;
+        decodeFrom(s.offset, s.before, [&](uint32_t v) { found = (v == target); return v < target; });
+        return found;
+    }
+
+    // False if the ID is negative or already present.
+    bool insert(int id) {
+        if (id < 0) return false;
+        uint32_t u = static_cast<uint32_t>(id);
+        if (count == 0 || u > last) { appendUnchecked(u); return true; }
+        if (contains(id)) return false;
+        std::vector<uint32_t> ids = toVector();
+        ids.insert(std::lower_bound(ids.begin(), ids.end(), u), u);
+        assignSorted(ids);
+        return true;
+    }
+
+    bool erase(int id) {
+        if (!contains(id)) return false;
+        std::vector<uint32_t> ids = toVector();
+        ids.erase(std::lower_bound(ids.begin(), ids.end(), static_cast<uint32_t>(id)));
+        assignSorted(ids);
+        return true;
+    }
+
+    // Calls f(int id) for every ID in ascending order
+    template <typename F>
+    void forEach(F&& f) const {
+        decodeFrom(0, 0, [&](uint32_t v) { f(static_cast<int>(v)); return true; });
+    }
+
+    std::vector<uint32_t> toVector() const {
+        std::vector<uint32_t> ids;
+        ids.reserve(count);
+        decodeFrom(0, 0, [&](uint32_t v) { ids.push_back(v); return true; });
+        return ids;
+    }
+
+    // Rebuilds from a stream produced by encoded(). False (and empty) if it is
+    // truncated or the IDs are not strictly increasing.
+    bool assignEncoded(std::string_view stream) {
+        clear();
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(stream.data());
+        const uint8_t* end = p + stream.size();
+        uint32_t prev = 0;
+        while (p < end) {
+            uint32_t delta;
+            if (!readVarint(p, end, delta) || (count > 0 && delta == 0) || prev + delta < prev) { clear(); return false; }
+            prev += delta;
+            appendUnchecked(prev);
+        }
+        return true;
+    }
+
+    // Builds from IDs in any order; duplicates are dropped. False (and
+    // empty) if any ID is negative.
+    bool assign(std::vector<int> ids) {
+        clear();
+        std::sort(ids.begin(), ids.end());
+        if (!ids.empty() && ids.front() < 0) return false;
+        for (size_t i = 0; i < ids.size(); ++i)
+            if (i == 0 || ids[i] != ids[i - 1]) appendUnchecked(static_cast<uint32_t>(ids[i]));
+        return true;
+    }
+};
+
+// --- Text form of binary data (base64url, no padding) ---
+// Used to keep encoded ID lists inside comma-separated data files: the
+// alphabet has no commas, quotes or ';'.
+
+namespace id_list_detail {
+
+constexpr char kBase64Url[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+constexpr int base64Value(char c) {
+    return (c >= 'A' && c <= 'Z') ? c - 'A' : (c >= 'a' && c <= 'z') ? c - 'a' + 26
+         : (c >= '0' && c <= '9') ? c - '0' + 52 : c == '-' ? 62 : c == '_' ? 63 : -1;
+}
+
+template <typename Out>
+void appendBase64(Out& out, std::string_view in) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(in.data());
+    size_t n = in.size(), i = 0;
+    char quad[4];
+    for (; i + 3 <= n; i += 3) {
+        uint32_t v = (uint32_t(p[i]) << 16) | (uint32_t(p[i + 1]) << 8) | p[i + 2];
+        quad[0] = kBase64Url[v >> 18]; quad[1] = kBase64Url[(v >> 12) & 63];
+        quad[2] = kBase64Url[(v >> 6) & 63]; quad[3] = kBase64Url[v & 63];
+        out << std::string_view(quad, 4);
+    }
+    if (n - i == 1) {
+        uint32_t v = uint32_t(p[i]) << 16;
+        quad[0] = kBase64Url[v >> 18]; quad[1] = kBase64Url[(v >> 12) & 63];
+        out << std::string_view(quad, 2);
+    } else if (n - i == 2) {
+        uint32_t v = (uint32_t(p[i]) << 16) | (uint32_t(p[i + 1]) << 8);
+        quad[0] = kBase64Url[v >> 18]; quad[1] = kBase64Url[(v >> 12) & 63]; quad[2] = kBase64Url[(v >> 6) & 63];
+        out << std::string_view(quad, 3);
+    }
+}
+
+inline bool decodeBase64(std::string_view in, std::string& out) {
+    out.clear();
+    if (in.size() % 4 == 1) return false;
+    uint32_t acc = 0;
+    int bits = 0;
+    for (char c : in) {
+        int v = base64Value(c);
+        if (v < 0) return false;
+        acc = (acc << 6) | uint32_t(v);
+        bits += 6;
+        if (bits >= 8) { bits -= 8; out.push_back(char((acc >> bits) & 0xFF)); }
+    }
+    return true;
+}
+
+} // namespace id_list_detail
+
+#endif // ID_LIST_H
@@ -0,0 +1,190 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include "csv_scanner.h"
+#include "output_buffer.h"
+
+// ** Mutation journal **
+// An append-only log of record-level changes, written by a primary and
+// tailed by read replicas (test --replica). Entries use the data files' own
+// CSV encoding, prefixed with a sequence number, the primary's wall clock in
+// milliseconds and a kind:
+//
+//     42,1760800000123,reg,17,1004,1
+//     43,1760800000130,reg-,17,1004
+//
+// so a replica decodes a record with the same fromFields/parseFields code
+// that loads the data files. What a kind means is up to the program; the
+// journal only frames entries. Each entry is written with one fwrite and
+// flushed, so a reader sees whole entries or a partial tail, never a torn
+// middle; JournalTail holds a partial tail back until its newline arrives.
+
+class JournalWriter {
+private:
+    std::FILE* file = nullptr;
+    uint64_t seq = 0;
+    OutputBuffer line;
+
+public:
+    JournalWriter() = default;
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+    ~JournalWriter() { close(); }
+
+    bool isOpen() const { return file != nullptr; }
+    uint64_t lastSeq() const { return seq; }
+
+    // Starts a new journal (an existing file is replaced)
+    bool open(const std::string& path) {
+        close();
+        file = std::fopen(path.c_str(), "wb");
+        seq = 0;
+        return file != nullptr;
+    }
+
+    void close() {
+        if (file) std::fclose(file);
+        file = nullptr;
+    }
+
+    static uint64_t nowMs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    // writeRecord(OutputBuffer&) appends the entry's CSV fields
+    template <typename WriteRecord>
+    void append(std::string_view kind, WriteRecord&& writeRecord) {
+        if (!file) return;
+        startEntry(kind);
+        line << ',';
+        writeRecord(line);
+        finishEntry();
+    }
+
+    // An entry with no fields (markers)
+    void append(std::string_view kind) {
+        if (!file) return;
+        startEntry(kind);
+        finishEntry();
+    }
+
+private:
+    void startEntry(std::string_view kind) {
+        line.clear();
+        line << ++seq << ',' << nowMs() << ',' << kind;
+    }
+
+    void finishEntry() {
+        line << '\n';
+        std::fwrite(line.data(), 1, line.size(), file);
+        std::fflush(file);
+    }
+};
+
+struct JournalEntry {
+    uint64_t seq = 0;
+    uint64_t timeMs = 0;
+    std::string_view kind;
+    CsvFields record; // The fields after the kind
+};
+
+// Follows a journal file (or FIFO) as it grows. poll() hands every complete
+// entry appended since the last call to onEntry. Sequence numbers must
+// follow on from the last entry delivered (or start again at 1). If they do
+// not, or the file shrank, the primary has restarted and replaced the
+// journal, and reading starts over from its beginning, which replays the new
+// journal from its "begin".
+class JournalTail {
+private:
+    std::string path;
+    std::FILE* file = nullptr;
+    uint64_t offset = 0;  // bytes consumed from the file
+    uint64_t lastSeq = 0; // of the last entry delivered
+    std::string pending;  // read but not yet a complete entry
+    std::string chunk;
+    JournalEntry entry;
+
+    static bool parseNumber(std::string_view text, uint64_t& out) {
+        if (text.empty()) return false;
+        out = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') return false;
+            out = out * 10 + uint64_t(c - '0');
+        }
+        return true;
+    }
+
+public:
+    explicit JournalTail(std::string journalPath) : path(std::move(journalPath)) { chunk.resize(1 << 16); }
+    JournalTail(const JournalTail&) = delete;
+    JournalTail& operator=(const JournalTail&) = delete;
+    ~JournalTail() { if (file) std::fclose(file); }
+
+    // Returns the number of entries delivered; malformed entries are
+    // reported through onError(text) and skipped
+    template <typename OnEntry, typename OnError>
+    size_t poll(OnEntry&& onEntry, OnError&& onError) {
+        std::error_code ec;
+        if (file && std::filesystem::is_regular_file(path, ec) && std::filesystem::file_size(path, ec) < offset && !ec)
+            reopen(); // Truncated: a new journal
+        size_t delivered = 0;
+        while (true) {
+            bool fromStart = !file || offset == 0; // This pass reads the file from its first line
+            if (!file) {
+                file = std::fopen(path.c_str(), "rb");
+                if (!file) return delivered;
+                offset = 0;
+                pending.clear();
+            }
+            size_t got;
+            while ((got = std::fread(&chunk[0], 1, chunk.size(), file)) > 0) {
+                pending.append(chunk.data(), got);
+                offset += got;
+            }
+            std::clearerr(file); // EOF is only "nothing yet"
+            size_t consumed = 0;
+            bool replaced = false;
+            CsvScanner scanner(pending);
+            CsvFields fields;
+            while (scanner.next(fields)) {
+                std::string_view text = scanner.recordText();
+                size_t end = static_cast<size_t>(text.data() - pending.data()) + text.size();
+                if (end >= pending.size()) break; // No newline yet: wait for the rest
+                bool parsed = fields.size() >= 3 && parseNumber(fields[0], entry.seq) && parseNumber(fields[1], entry.timeMs);
+                // A journal that grew past our offset after a restart puts us mid-line or out of sequence
+                if (!fromStart && (!parsed || (entry.seq != lastSeq + 1 && entry.seq != 1))) { replaced = true; break; }
+                consumed = end + 1;
+                if (!parsed) {
+                    onError(text);
+                    continue;
+                }
+                entry.kind = fields[2];
+                entry.record.assign(fields.begin() + 3, fields.end());
+                lastSeq = entry.seq;
+                onEntry(static_cast<const JournalEntry&>(entry));
+                ++delivered;
+            }
+            if (!replaced) {
+                pending.erase(0, consumed);
+                return delivered;
+            }
+            reopen();
+        }
+    }
+
+private:
+    void reopen() {
+        if (file) std::fclose(file);
+        file = nullptr;
+        lastSeq = 0;
+    }
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,277 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <locale>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "perf_counters.h"
+
+// ** Latency histograms **
+// Per-operation latency recording for the core operations of both programs
+// (login, registration, search, save, load, ...), so tail spikes such as a
+// full saveEvents() rewrite are visible instead of averaged away.
+// Each thread records into its own histograms, so recording takes no lock
+// and never contends: the counts are atomics written only by their thread
+// (relaxed load + store, no read-modify-write) and read by whoever merges.
+// A report merges all threads' histograms on demand. Thread data is never
+// freed, so counts from threads that have exited are still reported.
+//
+// Buckets are HDR-style log-linear: exact below 128 ns, then 64 sub-buckets
+// per power of two, so a reported value is within 1/64 (~1.6%) of the true
+// one, up to 2^40 ns (about 18 minutes; longer values count as that).
+//
+// Heap attribution (opt-in): when the program includes alloc_counter.h
+// before this header, so that operator new/delete are replaced, each scope
+// also adds the allocations and bytes its thread requested while it was
+// open, and the report shows them per call ("login: 14 allocs, 1.2 KB").
+// Nested operations are counted in each enclosing one as well.
+// Hardware counters (EMS_PERF=1, see perf_counters.h) are attributed the
+// same way and add cycles, instructions, IPC, cache and branch misses per
+// call to the report.
+
+#ifdef ALLOC_COUNTER_H
+#define LATENCY_COUNTS_ALLOCATIONS 1
+#endif
+
+class HdrHistogram {
+public:
+    static constexpr int kSubBucketBits = 7;
+    static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits; // 128
+    static constexpr uint64_t kHalf = kSubBuckets / 2;
+    static constexpr int kMaxBits = 40;
+    static constexpr size_t kBuckets = kSubBuckets + (kMaxBits - kSubBucketBits) * kHalf;
+
+    static size_t indexOf(uint64_t v) {
+        if (v >= (uint64_t(1) << kMaxBits)) v = (uint64_t(1) << kMaxBits) - 1;
+        if (v < kSubBuckets) return static_cast<size_t>(v);
+        int msb = 63 - countLeadingZeros(v);
+        int shift = msb - (kSubBucketBits - 1);
+        return static_cast<size_t>(kSubBuckets + (shift - 1) * kHalf + ((v >> shift) - kHalf));
+    }
+
+    // Highest value that falls in bucket i
+    static uint64_t highestEquivalent(size_t i) {
+        if (i < kSubBuckets) return i;
+        size_t k = i - kSubBuckets;
+        int shift = static_cast<int>(k / kHalf) + 1;
+        return ((kHalf + k % kHalf) << shift) + (uint64_t(1) << shift) - 1;
+    }
+
+    void record(uint64_t ns) {
+        bump(counts[indexOf(ns)], 1);
+        bump(total, 1);
+        if (ns > maxValue.load(std::memory_order_relaxed)) maxValue.store(ns, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+
+    // Counters have a single writer (their thread), so no read-modify-write
+    static void bump(std::atomic<uint64_t>& c, uint64_t n) { c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+
+    void mergeInto(uint64_t* out, uint64_t& count, uint64_t& max) const {
+        for (size_t i = 0; i < kBuckets; ++i) out[i] += counts[i].load(std::memory_order_relaxed);
+        count += total.load(std::memory_order_relaxed);
+        max = std::max(max, maxValue.load(std::memory_order_relaxed));
+    }
+
+private:
+    std::atomic<uint64_t> counts[kBuckets] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> maxValue{0};
+
+    static int countLeadingZeros(uint64_t v) {
+#if defined(__GNUC__)
+        return __builtin_clzll(v);
+#else
+        int n = 0; while (!(v & (uint64_t(1) << 63))) { v <<= 1; ++n; } return n;
+#endif
+    }
+};
+
+class LatencyStats {
+public:
+    static constexpr int kMaxOperations = 32;
+
+    // Registers an operation name (at static initialization) and returns its
+    // ID for record(); registering a name twice returns the same ID
+    static int operation(const char* name) {
+        Names& n = names();
+        for (int i = 0; i < n.count; ++i) if (std::string(n.name[i]) == name) return i;
+        if (n.count == kMaxOperations) return kMaxOperations - 1;
+        n.name[n.count] = name;
+        return n.count++;
+    }
+
+    static void record(int op, uint64_t ns, uint64_t allocations = 0, uint64_t bytes = 0) {
+        ThreadSlot& slot = threadSlot();
+        HdrHistogram* h = slot.ops[op].load(std::memory_order_relaxed);
+        if (!h) { h = new HdrHistogram(); slot.ops[op].store(h, std::memory_order_release); }
+        h->record(ns);
+        HdrHistogram::bump(slot.allocations[op], allocations);
+        HdrHistogram::bump(slot.allocatedBytes[op], bytes);
+    }
+
+    static void recordCounters(int op, const PerfSample& delta) {
+        std::atomic<uint64_t>* c = threadSlot().counters[op];
+        HdrHistogram::bump(c[0], 1);
+        HdrHistogram::bump(c[1], delta.cycles);
+        HdrHistogram::bump(c[2], delta.instructions);
+        HdrHistogram::bump(c[3], delta.cacheMisses);
+        HdrHistogram::bump(c[4], delta.branchMisses);
+    }
+
+    // Adds an operation's calls and attributed heap allocations/bytes, over
+    // all threads (allocations stay 0 unless they are counted)
+    static void totals(int op, uint64_t& calls, uint64_t& allocations, uint64_t& bytes) {
+        for (ThreadSlot* s = head().load(std::memory_order_acquire); s; s = s->next) {
+            if (const HdrHistogram* h = s->ops[op].load(std::memory_order_acquire)) calls += h->count();
+            allocations += s->allocations[op].load(std::memory_order_relaxed);
+            bytes += s->allocatedBytes[op].load(std::memory_order_relaxed);
+        }
+    }
+
+    // One line per operation with data: count, p50, p99, p99.9 and max in
+    // microseconds (the merged view of all threads)
+    static bool report(std::ostream& out) {
+        std::ios_base::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        std::locale loc = out.imbue(std::locale::classic());
+        out << std::left << std::setw(20) << "operation" << std::right << std::setw(10) << "count"
+            << std::setw(12) << "p50_us" << std::setw(12) << "p99_us" << std::setw(12) << "p99.9_us"
+            << std::setw(12) << "max_us";
+#ifdef LATENCY_COUNTS_ALLOCATIONS
+        out << std::setw(12) << "allocs/op" << std::setw(12) << "bytes/op";
+#endif
+        bool counters = anyCounters();
+        if (counters)
+            out << std::setw(14) << "cycles/op" << std::setw(14) << "instr/op" << std::setw(7) << "IPC"
+                << std::setw(12) << "cmiss/op" << std::setw(12) << "bmiss/op";
+        out << '\n' << std::fixed << std::setprecision(1);
+        bool any = false;
+        for (int op = 0; op < names().count; ++op) {
+            std::vector<uint64_t> merged(HdrHistogram::kBuckets);
+            uint64_t count = 0, max = 0;
+            for (ThreadSlot* s = head().load(std::memory_order_acquire); s; s = s->next)
+                if (const HdrHistogram* h = s->ops[op].load(std::memory_order_acquire)) h->mergeInto(merged.data(), count, max);
+            if (count == 0) continue;
+            any = true;
+            out << std::left << std::setw(20) << names().name[op] << std::right << std::setw(10) << count
+                << std::setw(12) << percentile(merged, count, max, 0.50) / 1000.0
+                << std::setw(12) << percentile(merged, count, max, 0.99) / 1000.0
+                << std::setw(12) << percentile(merged, count, max, 0.999) / 1000.0
+                << std::setw(12) << double(max) / 1000.0;
+#ifdef LATENCY_COUNTS_ALLOCATIONS
+            uint64_t calls = 0, allocations = 0, bytes = 0;
+            totals(op, calls, allocations, bytes);
+            out << std::setw(12) << double(allocations) / double(calls) << std::setw(12) << double(bytes) / double(calls);
+#endif
+            if (counters) {
+                uint64_t sum[5] = {};
+                for (ThreadSlot* s = head().load(std::memory_order_acquire); s; s = s->next)
+                    for (int i = 0; i < 5; ++i) sum[i] += s->counters[op][i].load(std::memory_order_relaxed);
+                double samples = sum[0] ? double(sum[0]) : 1;
+                out << std::setw(14) << double(sum[1]) / samples << std::setw(14) << double(sum[2]) / samples
+                    << std::setw(7) << std::setprecision(2) << (sum[1] ? double(sum[2]) / double(sum[1]) : 0.0) << std::setprecision(1)
+                    << std::setw(12) << double(sum[3]) / samples << std::setw(12) << double(sum[4]) / samples;
+            }
+            out << '\n';
+        }
+        if (!any) out << "(no operations recorded)\n";
+        out.flags(flags);
+        out.precision(precision);
+        out.imbue(loc);
+        return any;
+    }
+
+    // Shutdown dump: writes the report to path if anything was recorded
+    static void dump(const char* path) {
+        if (!anyRecorded()) return;
+        std::ofstream file(path);
+        if (file) report(file);
+    }
+
+private:
+    struct Names {
+        const char* name[kMaxOperations];
+        int count = 0;
+    };
+    struct ThreadSlot {
+        std::atomic<HdrHistogram*> ops[kMaxOperations] = {};
+        std::atomic<uint64_t> allocations[kMaxOperations] = {};
+        std::atomic<uint64_t> allocatedBytes[kMaxOperations] = {};
+        std::atomic<uint64_t> counters[kMaxOperations][5] = {}; // samples, cycles, instructions, cache/branch misses
+        ThreadSlot* next = nullptr;
+    };
+
+    static Names& names() { static Names n; return n; }
+    static std::atomic<ThreadSlot*>& head() { static std::atomic<ThreadSlot*> h{nullptr}; return h; }
+
+    // The calling thread's slot, pushed onto the list (lock-free) on first use
+    static ThreadSlot& threadSlot() {
+        thread_local ThreadSlot* slot = nullptr;
+        if (!slot) {
+            slot = new ThreadSlot();
+            ThreadSlot* old = head().load(std::memory_order_relaxed);
+            do { slot->next = old; } while (!head().compare_exchange_weak(old, slot, std::memory_order_release, std::memory_order_relaxed));
+        }
+        return *slot;
+    }
+
+    static bool anyCounters() {
+        for (ThreadSlot* s = head().load(std::memory_order_acquire); s; s = s->next)
+            for (const auto& c : s->counters) if (c[0].load(std::memory_order_relaxed)) return true;
+        return false;
+    }
+
+    static bool anyRecorded() {
+        for (ThreadSlot* s = head().load(std::memory_order_acquire); s; s = s->next)
+            for (const auto& h : s->ops) if (h.load(std::memory_order_acquire)) return true;
+        return false;
+    }
+
+    // Top of the bucket holding the p-th value, but never above the exact max
+    static double percentile(const std::vector<uint64_t>& merged, uint64_t count, uint64_t max, double p) {
+        uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(p * double(count) + 0.999999));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < HdrHistogram::kBuckets; ++i)
+            if ((seen += merged[i]) >= target) return double(std::min(HdrHistogram::highestEquivalent(i), max));
+        return double(max);
+    }
+};
+
+// Records the time from construction to destruction under one operation
+class LatencyScope {
+private:
+    int op;
+    PerfSample countersAtStart;
+    bool counting;  // Read before the clock, so the read is not timed
+    std::chrono::steady_clock::time_point start;
+#ifdef LATENCY_COUNTS_ALLOCATIONS
+    AllocationScope heap;
+#endif
+
+public:
+    explicit LatencyScope(int operation)
+        : op(operation), counting(PerfCounters::read(countersAtStart)), start(std::chrono::steady_clock::now()) {}
+    ~LatencyScope() {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        PerfSample countersAtEnd;
+        if (counting && PerfCounters::read(countersAtEnd)) LatencyStats::recordCounters(op, countersAtEnd - countersAtStart);
+#ifdef LATENCY_COUNTS_ALLOCATIONS
+        LatencyStats::record(op, static_cast<uint64_t>(ns), heap.allocations(), heap.bytes());
+#else
+        LatencyStats::record(op, static_cast<uint64_t>(ns));
+#endif
+    }
+    LatencyScope(const LatencyScope&) = delete;
+    LatencyScope& operator=(const LatencyScope&) = delete;
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,69 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <charconv>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+// ** OutputBuffer **
+// Formats text into a reusable in-memory buffer so a whole page (a listing,
+// a menu screen) or a whole data file is emitted with a single write.
+// clear() keeps the capacity, so a long-lived buffer stops allocating once
+// it has grown to the size of the largest page it renders.
+// Numbers are formatted with std::to_chars, which never consults the global
+// locale (so IDs are never written as "1,234" into a comma-separated file).
+class OutputBuffer {
+private:
+    std::string buf;
+
+    template <typename Int>
+    OutputBuffer& appendInt(Int value) {
+        char tmp[24];
+        auto res = std::to_chars(tmp, tmp + sizeof(tmp), value);
+        buf.append(tmp, static_cast<size_t>(res.ptr - tmp));
+        return *this;
+    }
+
+public:
+    OutputBuffer() { buf.reserve(4096); }
+
+    OutputBuffer& operator<<(std::string_view s) { buf.append(s.data(), s.size()); return *this; }
+    OutputBuffer& operator<<(const std::string& s) { buf.append(s); return *this; }
+    OutputBuffer& operator<<(const char* s) { buf.append(s); return *this; }
+    OutputBuffer& operator<<(char c) { buf.push_back(c); return *this; }
+    OutputBuffer& operator<<(int v) { return appendInt(v); }
+    OutputBuffer& operator<<(unsigned v) { return appendInt(v); }
+    OutputBuffer& operator<<(long v) { return appendInt(v); }
+    OutputBuffer& operator<<(unsigned long v) { return appendInt(v); }
+    OutputBuffer& operator<<(long long v) { return appendInt(v); }
+    OutputBuffer& operator<<(unsigned long long v) { return appendInt(v); }
+
+    void clear() { buf.clear(); }
+    bool empty() const { return buf.empty(); }
+    size_t size() const { return buf.size(); }
+    const char* data() const { return buf.data(); }
+    std::string_view view() const { return buf; }
+
+    // Emit the buffered page to a stream in one write and reset the buffer.
+    void flushTo(std::ostream& os) {
+        if (!buf.empty()) {
+            os.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            os.flush();
+        }
+        buf.clear();
+    }
+
+    // Replace the contents of a file with the buffer in one write.
+    // Returns false if the file cannot be opened or the write comes up short.
+    bool writeFile(const std::string& path) const {
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) return false;
+        bool ok = buf.empty() || std::fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+        ok = (std::fclose(f) == 0) && ok;
+        return ok;
+    }
+};
+
+#endif // OUTPUT_BUFFER_H
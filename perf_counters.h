@@ -0,0 +1,126 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PERF_COUNTERS_SUPPORTED 1
+#endif
+
+// ** Hardware performance counters **
+// Optional instrumentation mode (EMS_PERF=1 at startup) that counts CPU
+// cycles, instructions, cache misses and branch misses for the calling
+// thread with perf_event_open, so the latency report and --bench can show
+// what an operation is bound by: few instructions per cycle with many cache
+// misses is pointer chasing (e.g. through vector<User*>), many branch misses
+// is branchy parsing.
+// The four counters are opened once per thread as one group (user space
+// only) the first time that thread reads them, and read with a single
+// read() call. Where perf_event_open is unavailable (not Linux, containers,
+// kernel.perf_event_paranoid too high) a warning is printed once and
+// everything reads as zero; counters the CPU lacks (common in VMs) stay at
+// zero while the others still count.
+
+struct PerfSample {
+    uint64_t cycles = 0, instructions = 0, cacheMisses = 0, branchMisses = 0;
+
+    PerfSample operator-(const PerfSample& o) const {
+        return {cycles - o.cycles, instructions - o.instructions, cacheMisses - o.cacheMisses, branchMisses - o.branchMisses};
+    }
+};
+
+class PerfCounters {
+public:
+    static bool active() { return requested().load(std::memory_order_relaxed); }
+    static void enable(bool on) { requested().store(on, std::memory_order_relaxed); }
+
+    static void enableFromEnvironment() {
+        const char* value = std::getenv("EMS_PERF");
+        if (value && *value && std::strcmp(value, "0") != 0) enable(true);
+    }
+
+    // This thread's running totals; false (and zeros) if counting is off or
+    // the counters could not be opened
+    static bool read(PerfSample& out) {
+        out = PerfSample();
+        if (!active()) return false;
+#ifdef PERF_COUNTERS_SUPPORTED
+        Group& g = threadGroup();
+        if (g.leader < 0) return false;
+        uint64_t buffer[1 + kEvents];
+        ssize_t n = ::read(g.leader, buffer, sizeof buffer);
+        if (n < static_cast<ssize_t>(sizeof(uint64_t))) return false;
+        uint64_t* fields[kEvents] = {&out.cycles, &out.instructions, &out.cacheMisses, &out.branchMisses};
+        for (uint64_t i = 0; i < buffer[0] && i < kEvents; ++i) *fields[g.slot[i]] = buffer[1 + i];
+        return true;
+#else
+        return false;
+#endif
+    }
+
+private:
+    static constexpr int kEvents = 4;
+
+    static std::atomic<bool>& requested() { static std::atomic<bool> flag{false}; return flag; }
+
+#ifdef PERF_COUNTERS_SUPPORTED
+    struct Group {
+        int leader = -1;
+        int fds[kEvents] = {-1, -1, -1, -1};
+        int slot[kEvents] = {};  // group read position -> PerfSample field
+        ~Group() { for (int fd : fds) if (fd >= 0) close(fd); }
+    };
+
+    static int openEvent(uint64_t config, int groupFd) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof attr);
+        attr.size = sizeof attr;
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = groupFd == -1 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+    }
+
+    static Group& threadGroup() {
+        thread_local Group group;
+        thread_local bool opened = false;
+        if (opened) return group;
+        opened = true;
+        const uint64_t configs[kEvents] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                           PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        int position = 0;
+        for (int i = 0; i < kEvents; ++i) {
+            int fd = openEvent(configs[i], group.leader);
+            if (fd < 0) {
+                if (group.leader < 0) { // No cycles counter: give up on this thread
+                    static std::atomic<bool> warned{false};
+                    if (!warned.exchange(true))
+                        std::cerr << "Warn: Hardware counters unavailable (perf_event_open: " << std::strerror(errno) << ").\n";
+                    return group;
+                }
+                continue;
+            }
+            if (group.leader < 0) group.leader = fd;
+            group.fds[i] = fd;
+            group.slot[position++] = i;
+        }
+        ioctl(group.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(group.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return group;
+    }
+#endif
+};
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,387 @@
+#ifndef RECORD_SCHEMA_H
+#define RECORD_SCHEMA_H
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "output_buffer.h"
+#include "date_time.h"
+#include "id_list.h"
+#include "roaring_bitmap.h"
+
+// ** Record schemas **
+// Each persisted record type lists its fields once, in file order:
+//
+//     static constexpr auto schema() {
+//         return makeSchema(field("id", &Attendee::attendeeId), field("name", &Attendee::name), ...);
+//     }
+//
+// and the text (one comma-separated line) and binary encoders/decoders below
+// are generated from that list at compile time, so the on-disk layout cannot
+// drift from the field list. Numbers go through to_chars/from_chars; strings
+// are appended to / assigned from views of the input, never via stringstreams.
+
+template <typename Owner, typename Member>
+struct FieldDesc {
+    std::string_view name;
+    Member Owner::* ptr;
+};
+
+template <typename Owner, typename Member>
+constexpr FieldDesc<Owner, Member> field(std::string_view name, Member Owner::* ptr) {
+    return {name, ptr};
+}
+
+template <typename... Fields>
+constexpr std::tuple<Fields...> makeSchema(Fields... fields) {
+    return std::tuple<Fields...>(fields...);
+}
+
+// --- Per-type field codecs ---
+// Text: scalars as decimal, bool as 1/0, enums as their integer value,
+// vector<int> as "1;2;3", map<int,int> as "1:5;2:7". Strings containing a
+// comma, quote or line break are written RFC 4180 style: "a ""b"", c".
+// The ';'/':' sub-delimiters only ever separate integers, so lists are split
+// in the same from_chars pass that parses them.
+// Dates are written YYYY-MM-DD (either accepted form is read), times HH:MM.
+// An IdList is '*' followed by its delta-varint stream in base64url; the
+// older "1;2;3" form is still read. A RoaringBitmap is stored exactly like
+// an IdList of its members.
+// Binary: little-endian int32, u32-length-prefixed strings and containers,
+// packed dates and times as their integer values, IdList as its raw stream.
+
+namespace schema_detail {
+
+inline bool parseInt(std::string_view s, int& out) {
+    auto res = std::from_chars(s.data(), s.data() + s.size(), out);
+    return res.ec == std::errc() && res.ptr == s.data() + s.size();
+}
+
+inline void putU32(std::string& out, uint32_t v) {
+    char b[4] = { char(v & 0xFF), char((v >> 8) & 0xFF), char((v >> 16) & 0xFF), char((v >> 24) & 0xFF) };
+    out.append(b, 4);
+}
+
+inline bool getU32(std::string_view& in, uint32_t& v) {
+    if (in.size() < 4) return false;
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(in.data());
+    v = uint32_t(b[0]) | (uint32_t(b[1]) << 8) | (uint32_t(b[2]) << 16) | (uint32_t(b[3]) << 24);
+    in.remove_prefix(4);
+    return true;
+}
+
+template <typename M, typename = void>
+struct Codec;
+
+template <>
+struct Codec<int> {
+    static constexpr bool optional = false;
+    static void writeText(OutputBuffer& out, int v) { out << v; }
+    static bool readText(std::string_view s, int& v) { return parseInt(s, v); }
+    static void writeBinary(std::string& out, int v) { putU32(out, static_cast<uint32_t>(v)); }
+    static bool readBinary(std::string_view& in, int& v) {
+        uint32_t u; if (!getU32(in, u)) return false; v = static_cast<int>(u); return true;
+    }
+};
+
+template <>
+struct Codec<bool> {
+    static constexpr bool optional = false;
+    static void writeText(OutputBuffer& out, bool v) { out << (v ? '1' : '0'); }
+    static bool readText(std::string_view s, bool& v) { v = (s == "1"); return s == "1" || s == "0"; }
+    static void writeBinary(std::string& out, bool v) { out.push_back(v ? 1 : 0); }
+    static bool readBinary(std::string_view& in, bool& v) {
+        if (in.empty()) return false;
+        v = in[0] != 0; in.remove_prefix(1); return true;
+    }
+};
+
+template <>
+struct Codec<uint8_t> {
+    static constexpr bool optional = false;
+    static void writeText(OutputBuffer& out, uint8_t v) { out << static_cast<unsigned>(v); }
+    static bool readText(std::string_view s, uint8_t& v) {
+        int i; if (!parseInt(s, i) || i < 0 || i > 255) return false; v = static_cast<uint8_t>(i); return true;
+    }
+    static void writeBinary(std::string& out, uint8_t v) { out.push_back(static_cast<char>(v)); }
+    static bool readBinary(std::string_view& in, uint8_t& v) {
+        if (in.empty()) return false;
+        v = static_cast<uint8_t>(in[0]); in.remove_prefix(1); return true;
+    }
+};
+
+template <typename E>
+struct Codec<E, std::enable_if_t<std::is_enum<E>::value>> {
+    static constexpr bool optional = false;
+    static void writeText(OutputBuffer& out, E v) { out << static_cast<int>(v); }
+    static bool readText(std::string_view s, E& v) {
+        int i; if (!parseInt(s, i)) return false; v = static_cast<E>(i); return true;
+    }
+    static void writeBinary(std::string& out, E v) { Codec<int>::writeBinary(out, static_cast<int>(v)); }
+    static bool readBinary(std::string_view& in, E& v) {
+        int i; if (!Codec<int>::readBinary(in, i)) return false; v = static_cast<E>(i); return true;
+    }
+};
+
+template <>
+struct Codec<Date> {
+    static constexpr bool optional = false;
+    static void writeText(OutputBuffer& out, Date v) { out << v.iso().view(); }
+    static bool readText(std::string_view s, Date& v) { return parseDate(s, v); }
+    static void writeBinary(std::string& out, Date v) { putU32(out, v.packed); }
+    static bool readBinary(std::string_view& in, Date& v) { return getU32(in, v.packed); }
+};
+
+template <>
+struct Codec<TimeOfDay> {
+    static constexpr bool optional = false;
+    static void writeText(OutputBuffer& out, TimeOfDay v) { out << v.hhmm().view(); }
+    static bool readText(std::string_view s, TimeOfDay& v) { return parseTime(s, v); }
+    static void writeBinary(std::string& out, TimeOfDay v) { putU32(out, v.minutes); }
+    static bool readBinary(std::string_view& in, TimeOfDay& v) {
+        uint32_t u; if (!getU32(in, u)) return false; v.minutes = static_cast<uint16_t>(u); return true;
+    }
+};
+
+template <>
+struct Codec<std::string> {
+    static constexpr bool optional = false;
+    static void writeText(OutputBuffer& out, const std::string& v) {
+        if (v.find_first_of(",\"\r\n") == std::string::npos) { out << v; return; }
+        out << '"';
+        for (char ch : v) { if (ch == '"') out << '"'; out << ch; }
+        out << '"';
+    }
+    static bool readText(std::string_view s, std::string& v) {
+        if (s.size() < 2 || s.front() != '"' || s.back() != '"') { v.assign(s.data(), s.size()); return true; }
+        s = s.substr(1, s.size() - 2);
+        v.clear();
+        for (size_t i = 0; i < s.size(); ++i) {
+            v.push_back(s[i]);
+            if (s[i] == '"' && i + 1 < s.size() && s[i + 1] == '"') ++i;
+        }
+        return true;
+    }
+    static void writeBinary(std::string& out, const std::string& v) {
+        putU32(out, static_cast<uint32_t>(v.size())); out.append(v);
+    }
+    static bool readBinary(std::string_view& in, std::string& v) {
+        uint32_t n; if (!getU32(in, n) || in.size() < n) return false;
+        v.assign(in.data(), n); in.remove_prefix(n); return true;
+    }
+};
+
+template <>
+struct Codec<std::vector<int>> {
+    static constexpr bool optional = true; // A missing trailing list reads as empty
+    static void writeText(OutputBuffer& out, const std::vector<int>& v) {
+        for (size_t i = 0; i < v.size(); ++i) { if (i) out << ';'; out << v[i]; }
+    }
+    static bool readText(std::string_view s, std::vector<int>& v) {
+        v.clear();
+        const char* p = s.data();
+        const char* end = p + s.size();
+        while (p < end) {
+            if (*p == ';') { ++p; continue; }
+            int id;
+            auto res = std::from_chars(p, end, id);
+            if (res.ec != std::errc() || (res.ptr < end && *res.ptr != ';')) return false;
+            v.push_back(id);
+            p = res.ptr;
+        }
+        return true;
+    }
+    static void writeBinary(std::string& out, const std::vector<int>& v) {
+        putU32(out, static_cast<uint32_t>(v.size()));
+        for (int id : v) Codec<int>::writeBinary(out, id);
+    }
+    static bool readBinary(std::string_view& in, std::vector<int>& v) {
+        uint32_t n; if (!getU32(in, n) || in.size() / 4 < n) return false;
+        v.resize(n);
+        for (uint32_t i = 0; i < n; ++i) Codec<int>::readBinary(in, v[i]);
+        return true;
+    }
+};
+
+template <>
+struct Codec<IdList> {
+    static constexpr bool optional = true;
+    static void writeText(OutputBuffer& out, const IdList& ids) {
+        if (ids.empty()) return;
+        out << '*';
+        id_list_detail::appendBase64(out, ids.encoded());
+    }
+    static bool readText(std::string_view s, IdList& ids) {
+        if (s.empty() || s.front() != '*') {
+            std::vector<int> legacy;
+            return Codec<std::vector<int>>::readText(s, legacy) && ids.assign(std::move(legacy));
+        }
+        static thread_local std::string stream;
+        return id_list_detail::decodeBase64(s.substr(1), stream) && ids.assignEncoded(stream);
+    }
+    static void writeBinary(std::string& out, const IdList& ids) {
+        putU32(out, static_cast<uint32_t>(ids.encoded().size())); out.append(ids.encoded());
+    }
+    static bool readBinary(std::string_view& in, IdList& ids) {
+        uint32_t n; if (!getU32(in, n) || in.size() < n) return false;
+        bool ok = ids.assignEncoded(in.substr(0, n)); in.remove_prefix(n); return ok;
+    }
+};
+
+template <>
+struct Codec<RoaringBitmap> {
+    static constexpr bool optional = true;
+    static IdList& scratchList() { static thread_local IdList ids; return ids; }
+    static const IdList& toList(const RoaringBitmap& set) {
+        IdList& ids = scratchList();
+        ids.clear();
+        set.forEach([&](int id) { ids.insert(id); }); // Ascending, so every insert appends
+        return ids;
+    }
+    static void fromList(const IdList& ids, RoaringBitmap& set) {
+        set.clear();
+        ids.forEach([&](int id) { set.insert(id); });
+    }
+    static void writeText(OutputBuffer& out, const RoaringBitmap& set) { Codec<IdList>::writeText(out, toList(set)); }
+    static bool readText(std::string_view s, RoaringBitmap& set) {
+        if (!Codec<IdList>::readText(s, scratchList())) return false;
+        fromList(scratchList(), set);
+        return true;
+    }
+    static void writeBinary(std::string& out, const RoaringBitmap& set) { Codec<IdList>::writeBinary(out, toList(set)); }
+    static bool readBinary(std::string_view& in, RoaringBitmap& set) {
+        if (!Codec<IdList>::readBinary(in, scratchList())) return false;
+        fromList(scratchList(), set);
+        return true;
+    }
+};
+
+template <>
+struct Codec<std::map<int, int>> {
+    static constexpr bool optional = true;
+    static void writeText(OutputBuffer& out, const std::map<int, int>& m) {
+        bool first = true;
+        for (auto const& [key, value] : m) {
+            if (!first) out << ';';
+            out << key << ':' << value;
+            first = false;
+        }
+    }
+    // Malformed "key:value" entries are skipped, as they always were.
+    static bool readText(std::string_view s, std::map<int, int>& m) {
+        m.clear();
+        const char* p = s.data();
+        const char* end = p + s.size();
+        while (p < end) {
+            int key, value;
+            auto k = std::from_chars(p, end, key);
+            if (k.ec == std::errc() && k.ptr < end && *k.ptr == ':') {
+                auto v = std::from_chars(k.ptr + 1, end, value);
+                if (v.ec == std::errc() && (v.ptr == end || *v.ptr == ';')) {
+                    m[key] = value;
+                    p = v.ptr;
+                    if (p < end) ++p;
+                    continue;
+                }
+            }
+            while (p < end && *p != ';') ++p; // Skip the malformed entry
+            if (p < end) ++p;
+        }
+        return true;
+    }
+    static void writeBinary(std::string& out, const std::map<int, int>& m) {
+        putU32(out, static_cast<uint32_t>(m.size()));
+        for (auto const& [key, value] : m) { Codec<int>::writeBinary(out, key); Codec<int>::writeBinary(out, value); }
+    }
+    static bool readBinary(std::string_view& in, std::map<int, int>& m) {
+        uint32_t n; if (!getU32(in, n) || in.size() / 8 < n) return false;
+        m.clear();
+        for (uint32_t i = 0; i < n; ++i) {
+            int key, value;
+            Codec<int>::readBinary(in, key); Codec<int>::readBinary(in, value);
+            m.emplace_hint(m.end(), key, value);
+        }
+        return true;
+    }
+};
+
+template <typename F>
+struct FieldMember;
+template <typename Owner, typename Member>
+struct FieldMember<FieldDesc<Owner, Member>> { using type = Member; };
+
+template <typename F>
+using CodecFor = Codec<typename FieldMember<F>::type>;
+
+[[noreturn]] inline void badField(std::string_view fieldName) {
+    throw std::invalid_argument("bad or missing field '" + std::string(fieldName) + "'");
+}
+
+} // namespace schema_detail
+
+// Append rec as one comma-separated line (without the trailing newline).
+template <typename T>
+void appendText(OutputBuffer& out, const T& rec) {
+    std::apply([&](const auto&... f) {
+        bool first = true;
+        ((out << (first ? "" : ","),
+          schema_detail::CodecFor<std::decay_t<decltype(f)>>::writeText(out, rec.*(f.ptr)),
+          first = false), ...);
+    }, T::schema());
+}
+
+// Fill rec from the raw fields of one record (see CsvScanner). Trailing list
+// fields may be omitted. Extra fields are only accepted when the last schema
+// field is a string: files written before quoting existed stored unquoted
+// commas there, so the rest of the record is taken as that field.
+// Throws std::invalid_argument naming the first bad field.
+template <typename T>
+void parseFields(const std::vector<std::string_view>& fields, T& rec) {
+    constexpr size_t count = std::tuple_size<decltype(T::schema())>::value;
+    size_t index = 0;
+    std::apply([&](const auto&... f) {
+        ((void)([&] {
+            using C = schema_detail::CodecFor<std::decay_t<decltype(f)>>;
+            std::string_view value;
+            if (index >= fields.size()) {
+                if (!C::optional) schema_detail::badField(f.name);
+            } else if (index + 1 == count && fields.size() > count) {
+                if (!std::is_same<typename schema_detail::FieldMember<std::decay_t<decltype(f)>>::type, std::string>::value) {
+                    throw std::invalid_argument("too many fields");
+                }
+                const char* begin = fields[index].data();
+                value = std::string_view(begin, static_cast<size_t>(fields.back().data() + fields.back().size() - begin));
+            } else {
+                value = fields[index];
+            }
+            if (!C::readText(value, rec.*(f.ptr))) schema_detail::badField(f.name);
+            ++index;
+        }()), ...);
+    }, T::schema());
+}
+
+// Append rec in the binary record layout.
+template <typename T>
+void appendBinary(std::string& out, const T& rec) {
+    std::apply([&](const auto&... f) {
+        (schema_detail::CodecFor<std::decay_t<decltype(f)>>::writeBinary(out, rec.*(f.ptr)), ...);
+    }, T::schema());
+}
+
+// Fill rec from the front of in, consuming the bytes read.
+template <typename T>
+void parseBinary(std::string_view& in, T& rec) {
+    std::apply([&](const auto&... f) {
+        ((schema_detail::CodecFor<std::decay_t<decltype(f)>>::readBinary(in, rec.*(f.ptr))
+              ? void() : schema_detail::badField(f.name)), ...);
+    }, T::schema());
+}
+
+#endif // RECORD_SCHEMA_H
@@ -0,0 +1,298 @@
+#ifndef ROARING_BITMAP_H
+#define ROARING_BITMAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// ** RoaringBitmap **
+// Compressed set of non-negative 32-bit IDs with fast set algebra
+// (intersection, union, difference), for attendee sets and the audience
+// queries built on them.
+// IDs are split by their high 16 bits into containers of up to 65536 values.
+// A container holds a sorted array of the low 16 bits while it has at most
+// 4096 members (8 KB or less) and switches to a 65536-bit bitmap (always
+// 8 KB) once it is denser, so each container takes whichever form is
+// smaller. Operations work container by container: array against array is
+// a sorted merge, bitmap against bitmap is a word-wise AND/OR/AND-NOT with
+// popcount, and mixed pairs probe the bitmap. Run-length containers from
+// the full Roaring format are left out; attendee IDs rarely form long runs.
+class RoaringBitmap {
+private:
+    static constexpr uint32_t kArrayMax = 4096;
+    static constexpr size_t kWords = 65536 / 64;
+
+    struct Container {
+        uint16_t key = 0;              // high 16 bits of every member
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> array;   // sorted low bits, when bits is empty
+        std::vector<uint64_t> bits;    // kWords words, when in bitmap form
+
+        bool isBitmap() const { return !bits.empty(); }
+
+        bool contains(uint16_t low) const {
+            if (isBitmap()) return (bits[low >> 6] >> (low & 63)) & 1;
+            return std::binary_search(array.begin(), array.end(), low);
+        }
+
+        void toBitmap() {
+            bits.assign(kWords, 0);
+            for (uint16_t low : array) bits[low >> 6] |= uint64_t(1) << (low & 63);
+            array.clear();
+            array.shrink_to_fit();
+        }
+
+        void toArray() {
+            std::vector<uint16_t> out;
+            out.reserve(cardinality);
+            forEachLow([&](uint16_t low) { out.push_back(low); });
+            array.swap(out);
+            bits.clear();
+            bits.shrink_to_fit();
+        }
+
+        // Recount a bitmap and pick the smaller form
+        void normalize() {
+            if (isBitmap()) {
+                cardinality = 0;
+                for (uint64_t w : bits) cardinality += popcount(w);
+                if (cardinality <= kArrayMax) toArray();
+            } else {
+                cardinality = static_cast<uint32_t>(array.size());
+                if (cardinality > kArrayMax) toBitmap();
+            }
+        }
+
+        template <typename F>
+        void forEachLow(F&& f) const {
+            if (!isBitmap()) { for (uint16_t low : array) f(low); return; }
+            for (size_t i = 0; i < kWords; ++i)
+                for (uint64_t w = bits[i]; w; w &= w - 1)
+                    f(static_cast<uint16_t>(i * 64 + lowestBit(w)));
+        }
+    };
+
+    std::vector<Container> containers; // sorted by key
+    size_t total = 0;
+
+    static uint32_t popcount(uint64_t w) {
+#if defined(__GNUC__)
+        return static_cast<uint32_t>(__builtin_popcountll(w));
+#else
+        uint32_t n = 0; for (; w; w &= w - 1) ++n; return n;
+#endif
+    }
+
+    static int lowestBit(uint64_t w) {
+#if defined(__GNUC__)
+        return __builtin_ctzll(w);
+#else
+        int n = 0; while (!(w & 1)) { w >>= 1; ++n; } return n;
+#endif
+    }
+
+    std::vector<Container>::iterator lowerBound(uint16_t key) {
+        return std::lower_bound(containers.begin(), containers.end(), key,
+                                [](const Container& c, uint16_t k) { return c.key < k; });
+    }
+    std::vector<Container>::const_iterator lowerBound(uint16_t key) const {
+        return std::lower_bound(containers.begin(), containers.end(), key,
+                                [](const Container& c, uint16_t k) { return c.key < k; });
+    }
+
+    // --- Container pair operations (same key) ---
+
+    static Container andOf(const Container& a, const Container& b) {
+        Container out;
+        out.key = a.key;
+        if (a.isBitmap() && b.isBitmap()) {
+            out.bits.resize(kWords);
+            for (size_t i = 0; i < kWords; ++i) out.bits[i] = a.bits[i] & b.bits[i];
+        } else if (!a.isBitmap() && !b.isBitmap()) {
+            std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                                  std::back_inserter(out.array));
+        } else {
+            const Container& arr = a.isBitmap() ? b : a;
+            const Container& bmp = a.isBitmap() ? a : b;
+            for (uint16_t low : arr.array) if (bmp.contains(low)) out.array.push_back(low);
+        }
+        out.normalize();
+        return out;
+    }
+
+    static Container orOf(const Container& a, const Container& b) {
+        Container out;
+        out.key = a.key;
+        if (!a.isBitmap() && !b.isBitmap()) {
+            out.array.reserve(a.array.size() + b.array.size());
+            std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                           std::back_inserter(out.array));
+        } else {
+            const Container& bmp = a.isBitmap() ? a : b;
+            const Container& other = a.isBitmap() ? b : a;
+            out.bits = bmp.bits;
+            if (other.isBitmap()) for (size_t i = 0; i < kWords; ++i) out.bits[i] |= other.bits[i];
+            else for (uint16_t low : other.array) out.bits[low >> 6] |= uint64_t(1) << (low & 63);
+        }
+        out.normalize();
+        return out;
+    }
+
+    static Container andNotOf(const Container& a, const Container& b) {
+        Container out;
+        out.key = a.key;
+        if (!a.isBitmap()) {
+            if (b.isBitmap()) { for (uint16_t low : a.array) if (!b.contains(low)) out.array.push_back(low); }
+            else std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                                     std::back_inserter(out.array));
+        } else {
+            out.bits = a.bits;
+            if (b.isBitmap()) for (size_t i = 0; i < kWords; ++i) out.bits[i] &= ~b.bits[i];
+            else for (uint16_t low : b.array) out.bits[low >> 6] &= ~(uint64_t(1) << (low & 63));
+        }
+        out.normalize();
+        return out;
+    }
+
+    void push(Container&& c) {
+        if (c.cardinality == 0) return;
+        total += c.cardinality;
+        containers.push_back(std::move(c));
+    }
+
+public:
+    size_t size() const { return total; }
+    bool empty() const { return total == 0; }
+    void clear() { containers.clear(); total = 0; }
+
+    bool contains(int id) const {
+        if (id < 0) return false;
+        uint32_t u = static_cast<uint32_t>(id);
+        auto it = lowerBound(static_cast<uint16_t>(u >> 16));
+        return it != containers.end() && it->key == (u >> 16) && it->contains(static_cast<uint16_t>(u));
+    }
+
+    // False if the ID is negative or already present.
+    bool insert(int id) {
+        if (id < 0) return false;
+        uint32_t u = static_cast<uint32_t>(id);
+        uint16_t key = static_cast<uint16_t>(u >> 16), low = static_cast<uint16_t>(u);
+        auto it = lowerBound(key);
+        if (it == containers.end() || it->key != key) {
+            it = containers.insert(it, Container());
+            it->key = key;
+        }
+        if (it->isBitmap()) {
+            uint64_t& w = it->bits[low >> 6];
+            uint64_t bit = uint64_t(1) << (low & 63);
+            if (w & bit) return false;
+            w |= bit;
+        } else {
+            auto pos = std::lower_bound(it->array.begin(), it->array.end(), low);
+            if (pos != it->array.end() && *pos == low) return false;
+            it->array.insert(pos, low);
+            if (it->array.size() > kArrayMax) it->toBitmap();
+        }
+        ++it->cardinality;
+        ++total;
+        return true;
+    }
+
+    bool erase(int id) {
+        if (!contains(id)) return false;
+        uint32_t u = static_cast<uint32_t>(id);
+        auto it = lowerBound(static_cast<uint16_t>(u >> 16));
+        uint16_t low = static_cast<uint16_t>(u);
+        if (it->isBitmap()) {
+            it->bits[low >> 6] &= ~(uint64_t(1) << (low & 63));
+            if (--it->cardinality <= kArrayMax) it->toArray();
+        } else {
+            it->array.erase(std::lower_bound(it->array.begin(), it->array.end(), low));
+            --it->cardinality;
+        }
+        if (it->cardinality == 0) containers.erase(it);
+        --total;
+        return true;
+    }
+
+    // Calls f(int id) for every member in ascending order
+    template <typename F>
+    void forEach(F&& f) const {
+        for (const Container& c : containers) {
+            uint32_t high = uint32_t(c.key) << 16;
+            c.forEachLow([&](uint16_t low) { f(static_cast<int>(high | low)); });
+        }
+    }
+
+    // --- Set algebra ---
+
+    friend RoaringBitmap operator&(const RoaringBitmap& a, const RoaringBitmap& b) {
+        RoaringBitmap out;
+        auto i = a.containers.begin(), j = b.containers.begin();
+        while (i != a.containers.end() && j != b.containers.end()) {
+            if (i->key < j->key) ++i;
+            else if (j->key < i->key) ++j;
+            else out.push(andOf(*i++, *j++));
+        }
+        return out;
+    }
+
+    friend RoaringBitmap operator|(const RoaringBitmap& a, const RoaringBitmap& b) {
+        RoaringBitmap out;
+        auto i = a.containers.begin(), j = b.containers.begin();
+        while (i != a.containers.end() || j != b.containers.end()) {
+            if (j == b.containers.end() || (i != a.containers.end() && i->key < j->key)) out.push(Container(*i++));
+            else if (i == a.containers.end() || j->key < i->key) out.push(Container(*j++));
+            else out.push(orOf(*i++, *j++));
+        }
+        return out;
+    }
+
+    // Members of a that are not in b
+    friend RoaringBitmap operator-(const RoaringBitmap& a, const RoaringBitmap& b) {
+        RoaringBitmap out;
+        auto j = b.containers.begin();
+        for (const Container& c : a.containers) {
+            while (j != b.containers.end() && j->key < c.key) ++j;
+            if (j != b.containers.end() && j->key == c.key) out.push(andNotOf(c, *j));
+            else out.push(Container(c));
+        }
+        return out;
+    }
+
+    RoaringBitmap& operator&=(const RoaringBitmap& b) { return *this = *this & b; }
+    RoaringBitmap& operator|=(const RoaringBitmap& b) { return *this = *this | b; }
+    RoaringBitmap& operator-=(const RoaringBitmap& b) { return *this = *this - b; }
+
+    // Size of the intersection without building it
+    size_t intersectionSize(const RoaringBitmap& b) const {
+        size_t n = 0;
+        auto i = containers.begin(), j = b.containers.begin();
+        while (i != containers.end() && j != b.containers.end()) {
+            if (i->key < j->key) { ++i; continue; }
+            if (j->key < i->key) { ++j; continue; }
+            if (i->isBitmap() && j->isBitmap()) {
+                for (size_t w = 0; w < kWords; ++w) n += popcount(i->bits[w] & j->bits[w]);
+            } else {
+                const Container& arr = i->isBitmap() ? *j : *i;
+                const Container& other = i->isBitmap() ? *i : *j;
+                for (uint16_t low : arr.array) n += other.contains(low);
+            }
+            ++i; ++j;
+        }
+        return n;
+    }
+
+    friend bool operator==(const RoaringBitmap& a, const RoaringBitmap& b) {
+        if (a.total != b.total || a.containers.size() != b.containers.size()) return false;
+        for (size_t i = 0; i < a.containers.size(); ++i) {
+            const Container& x = a.containers[i];
+            const Container& y = b.containers[i];
+            if (x.key != y.key || x.cardinality != y.cardinality || x.array != y.array || x.bits != y.bits) return false;
+        }
+        return true;
+    }
+};
+
+#endif // ROARING_BITMAP_H
@@ -0,0 +1,214 @@
+#ifndef SAMPLING_PROFILER_H
+#define SAMPLING_PROFILER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#define SAMPLING_PROFILER_SUPPORTED 1
+#endif
+
+// ** Sampling profiler **
+// In-process CPU profiler: ITIMER_PROF delivers SIGPROF every 1/hz seconds
+// of CPU time, and the handler stores the interrupted call stack into a
+// buffer allocated when profiling starts (the handler itself does not
+// allocate or lock). Stopping disarms the timer, then symbolizes and writes
+// the stacks in folded form, one line per distinct stack, root first:
+//
+//     main;System::run;System::saveEvents 42
+//
+// which flamegraph.pl, speedscope and similar tools read directly.
+// Function names come from the dynamic symbol table, so link with
+// -rdynamic to see names for the program's own functions; otherwise those
+// frames appear as [program+0xoffset].
+// Ways to start and stop it:
+//   - the "profile start [hz]" / "profile stop <file>" admin batch commands
+//   - EMS_PROFILE=<file>: profile the whole run, written at exit
+//   - with EMS_PROFILE_SIGNAL=1, kill -USR2 <pid> toggles profiling of a
+//     running process, writing profile-<pid>.folded on the second signal.
+//     A helper thread waits for the signal with sigwait(), so the file is
+//     not written from a handler.
+// Only POSIX systems are supported; elsewhere start() returns false.
+
+class SamplingProfiler {
+public:
+    static constexpr int kMaxDepth = 48;
+    static constexpr uint32_t kMaxSamples = 20000;
+
+    static bool running() { return state().running.load(std::memory_order_relaxed); }
+
+    // False if already running or not supported here
+    static bool start(int hz = 99) {
+#ifdef SAMPLING_PROFILER_SUPPORTED
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.control);
+        if (s.running.load()) return false;
+        if (hz < 1) hz = 1;
+        if (hz > 1000) hz = 1000;
+        s.frames.assign(size_t(kMaxSamples) * kMaxDepth, nullptr);
+        s.depth.assign(kMaxSamples, 0);
+        s.used.store(0);
+        s.dropped.store(0);
+        void* warm[4];
+        backtrace(warm, 4); // The first call may load the unwinder; do it outside the handler
+        struct sigaction sa = {};
+        sa.sa_handler = onSample;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGPROF, &sa, nullptr);
+        itimerval timer = {};
+        timer.it_interval.tv_usec = 1000000 / hz;
+        timer.it_value = timer.it_interval;
+        s.running.store(true);
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        return true;
+#else
+        (void)hz;
+        return false;
+#endif
+    }
+
+    // Stops sampling and writes the folded stacks to path. Returns the
+    // number of samples written (0 if it was not running).
+    static size_t stop(const std::string& path) {
+#ifdef SAMPLING_PROFILER_SUPPORTED
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.control);
+        if (!s.running.load()) return 0;
+        itimerval off = {};
+        setitimer(ITIMER_PROF, &off, nullptr);
+        signal(SIGPROF, SIG_IGN); // A tick already on its way is dropped
+        s.running.store(false);
+        uint32_t used = std::min(s.used.load(std::memory_order_acquire), kMaxSamples);
+        std::map<std::string, size_t> folded;
+        std::map<void*, std::string> names;
+        std::string stack;
+        for (uint32_t i = 0; i < used; ++i) {
+            void** frames = &s.frames[size_t(i) * kMaxDepth];
+            int depth = s.depth[i];
+            stack.clear();
+            // Frames 0 and 1 are this handler and the kernel's signal trampoline
+            for (int f = depth - 1; f >= 2; --f) {
+                void* pc = static_cast<char*>(frames[f]) - (f > 2 ? 1 : 0); // Return address -> call site
+                auto it = names.find(pc);
+                if (it == names.end()) it = names.emplace(pc, symbolize(pc)).first;
+                if (!stack.empty()) stack += ';';
+                stack += it->second;
+            }
+            if (!stack.empty()) ++folded[stack];
+        }
+        std::ofstream out(path);
+        for (const auto& entry : folded) out << entry.first << ' ' << entry.second << '\n';
+        // s.frames stays allocated: a handler on another thread may still be
+        // storing its last sample. start() reuses it for the next profile.
+        return used;
+#else
+        (void)path;
+        return 0;
+#endif
+    }
+
+    static uint32_t droppedSamples() { return state().dropped.load(std::memory_order_relaxed); }
+
+    // EMS_PROFILE=<file>: profile from startup and write the file at exit
+    static void enableFromEnvironment() {
+        const char* path = std::getenv("EMS_PROFILE");
+        if (!path || !*path || !start()) return;
+        std::atexit([] { stop(std::getenv("EMS_PROFILE")); });
+    }
+
+    // EMS_PROFILE_SIGNAL=1: kill -USR2 <pid> starts profiling; a second one
+    // stops it and writes profile-<pid>.folded into the startup directory
+    // (its full path is built here, before any mode changes directory).
+    // Off by default, so SIGUSR2 keeps its usual meaning and no helper
+    // thread is started. Call early in main, before any other thread
+    // exists, so they all inherit the blocked mask.
+    static void enableSignalToggle() {
+#ifdef SAMPLING_PROFILER_SUPPORTED
+        const char* flag = std::getenv("EMS_PROFILE_SIGNAL");
+        if (!flag || !*flag || std::string(flag) == "0") return;
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGUSR2);
+        pthread_sigmask(SIG_BLOCK, &set, nullptr);
+        char cwd[4096];
+        std::string path = getcwd(cwd, sizeof cwd) ? std::string(cwd) + "/" : std::string();
+        path += "profile-" + std::to_string(getpid()) + ".folded";
+        std::thread([set, path] {
+            while (true) {
+                int sig = 0;
+                if (sigwait(&set, &sig) != 0) continue;
+                if (!running()) start();
+                else stop(path);
+            }
+        }).detach();
+#endif
+    }
+
+private:
+    struct State {
+        std::mutex control;
+        std::atomic<bool> running{false};
+        std::vector<void*> frames;   // kMaxSamples stacks of kMaxDepth frames
+        std::vector<int> depth;
+        std::atomic<uint32_t> used{0};
+        std::atomic<uint32_t> dropped{0};
+    };
+
+    static State& state() { static State s; return s; }
+
+#ifdef SAMPLING_PROFILER_SUPPORTED
+    static void onSample(int) {
+        int savedErrno = errno;
+        State& s = state();
+        uint32_t i = s.used.fetch_add(1, std::memory_order_relaxed);
+        if (i < kMaxSamples && s.running.load(std::memory_order_relaxed)) {
+            s.depth[i] = backtrace(&s.frames[size_t(i) * kMaxDepth], kMaxDepth);
+        } else {
+            s.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        errno = savedErrno;
+    }
+
+    static std::string symbolize(void* pc) {
+        Dl_info info;
+        if (dladdr(pc, &info) && info.dli_sname) {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            std::string name = status == 0 && demangled ? demangled : info.dli_sname;
+            std::free(demangled);
+            return name;
+        }
+        std::string module = "?";
+        uintptr_t base = 0;
+        if (dladdr(pc, &info) && info.dli_fname) {
+            module = info.dli_fname;
+            size_t slash = module.rfind('/');
+            if (slash != std::string::npos) module.erase(0, slash + 1);
+            base = reinterpret_cast<uintptr_t>(info.dli_fbase);
+        }
+        char offset[32];
+        std::snprintf(offset, sizeof offset, "+0x%llx", static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(pc) - base));
+        return "[" + module + offset + "]";
+    }
+#endif
+};
+
+#endif // SAMPLING_PROFILER_H
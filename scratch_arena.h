@@ -0,0 +1,60 @@
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ** ScratchArena **
+// Bump allocator for the temporaries of one request (a menu action or a batch
+// command): input lines, search results, NUL-terminated copies of command
+// tokens. Containers take it through std::pmr, e.g.
+//
+//     ScratchArena::Scope request(scratch);
+//     std::pmr::vector<const Event*> found(scratch.resource());
+//
+// Deallocation is a no-op; everything is released in one step when the
+// outermost Scope ends, rewinding to the start of a buffer allocated once.
+// A request that outgrows the buffer borrows extra blocks from the heap,
+// which are returned at the same point.
+class ScratchArena {
+private:
+    std::unique_ptr<std::byte[]> buffer;
+    std::pmr::monotonic_buffer_resource arena;
+    int depth = 0;
+
+public:
+    explicit ScratchArena(size_t capacity = 64 * 1024)
+        : buffer(new std::byte[capacity]), arena(buffer.get(), capacity, std::pmr::new_delete_resource()) {}
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &arena; }
+
+    // NUL-terminated arena copy of s for C-string APIs
+    const char* cstr(std::string_view s) {
+        char* p = static_cast<char*>(arena.allocate(s.size() + 1, 1));
+        std::memcpy(p, s.data(), s.size());
+        p[s.size()] = '\0';
+        return p;
+    }
+
+    // Marks one request. Nested scopes (a batch command run from inside
+    // another request) keep the arena until the outermost one ends.
+    class Scope {
+    private:
+        ScratchArena& owner;
+
+    public:
+        explicit Scope(ScratchArena& a) : owner(a) { ++owner.depth; }
+        ~Scope() { if (--owner.depth == 0) owner.arena.release(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};
+
+#endif // SCRATCH_ARENA_H
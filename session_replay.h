@@ -0,0 +1,197 @@
+#ifndef SESSION_REPLAY_H
+#define SESSION_REPLAY_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <locale>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ** Session replay **
+// Drives a program's interactive menus in-process (--replay) and times each
+// logical operation from the keystroke that chooses it to its result.
+// A session is plain text, one keystroke line per line, exactly as typed at
+// the prompts (so `tee session.txt | program` records one). Lines starting
+// with '@' name the operation the following lines belong to; '#' lines are
+// comments. Lines before the first '@' form the operation "(start)".
+//
+//     @login
+//     1
+//     admin
+//     adminpass
+//     @browse-events
+//     1
+//
+// While a session runs, std::cin reads from it and std::cout writes to an
+// in-memory buffer. An operation's time runs from the moment its first line
+// is handed to the program until the program asks for the first line of the
+// next operation, so it covers parsing, the work and all output (including
+// the flush of cout when cin is read). Output bytes and flushes (sync calls,
+// e.g. std::endl) are counted per operation as well; an extra flush or a
+// redundant scan shows up as a jump in these numbers.
+// When the session runs out, reading throws ReplayFinished out of the menu
+// loop. Sessions for final_project must not choose Exit, which calls exit().
+// Results are CSV, one row per operation name over all repetitions:
+//
+//     program,operation,count,median_ns,p90_ns,max_ns,output_bytes,flushes
+
+struct ReplayFinished {}; // Not a std::exception, so menu loops let it through
+
+struct ReplaySession {
+    struct Operation {
+        std::string name;
+        std::vector<std::string> lines;
+    };
+    std::vector<Operation> operations;
+
+    static ReplaySession parse(std::istream& in) {
+        ReplaySession session;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty() && line[0] == '#') continue;
+            if (!line.empty() && line[0] == '@') { session.operations.push_back({line.substr(1), {}}); continue; }
+            if (session.operations.empty()) session.operations.push_back({"(start)", {}});
+            session.operations.back().lines.push_back(line);
+        }
+        return session;
+    }
+};
+
+class SessionReplayer {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        std::string name;
+        std::vector<double> ns;
+        uint64_t bytes = 0, flushes = 0;
+    };
+
+    // Serves the session one line per underflow, i.e. each time the program
+    // asks for more input
+    class InputBuf : public std::streambuf {
+    public:
+        SessionReplayer& owner;
+        std::string current;
+        explicit InputBuf(SessionReplayer& r) : owner(r) {}
+    protected:
+        int_type underflow() override {
+            if (!owner.nextLine(current)) throw ReplayFinished{};
+            setg(current.data(), current.data(), current.data() + current.size());
+            return traits_type::to_int_type(current[0]);
+        }
+    };
+
+    // Stand-in for stdout: a 4 KB buffer that is counted and discarded when
+    // full or flushed
+    class OutputBuf : public std::streambuf {
+    public:
+        char buffer[4096];
+        uint64_t bytes = 0, flushes = 0;
+        OutputBuf() { setp(buffer, buffer + sizeof buffer); }
+        void drain() { bytes += static_cast<uint64_t>(pptr() - pbase()); setp(buffer, buffer + sizeof buffer); }
+    protected:
+        int_type overflow(int_type c) override {
+            drain();
+            if (!traits_type::eq_int_type(c, traits_type::eof())) { *pptr() = traits_type::to_char_type(c); pbump(1); }
+            return traits_type::not_eof(c);
+        }
+        int sync() override { drain(); ++flushes; return 0; }
+    };
+
+    const ReplaySession& session;
+    std::vector<Stats> stats;          // one per distinct operation name, in first-seen order
+    std::vector<size_t> statIndex;     // session operation -> stats entry
+    size_t op = 0, line = 0;           // next line to hand out
+    bool open = false;
+    Clock::time_point opStart;
+    uint64_t bytesAtStart = 0, flushesAtStart = 0;
+    OutputBuf output;
+
+    void closeOperation(Clock::time_point now) {
+        if (!open) return;
+        output.drain();
+        Stats& s = stats[statIndex[op]];
+        s.ns.push_back(std::chrono::duration<double, std::nano>(now - opStart).count());
+        s.bytes += output.bytes - bytesAtStart;
+        s.flushes += output.flushes - flushesAtStart;
+        open = false;
+        ++op;
+        line = 0;
+    }
+
+    bool nextLine(std::string& out) {
+        Clock::time_point now = Clock::now();
+        if (open && line == session.operations[op].lines.size()) closeOperation(now);
+        while (!open && op < session.operations.size() && session.operations[op].lines.empty()) ++op;
+        if (op == session.operations.size()) return false;
+        if (!open) {
+            output.drain();
+            open = true;
+            opStart = now;
+            bytesAtStart = output.bytes;
+            flushesAtStart = output.flushes;
+        }
+        out = session.operations[op].lines[line++];
+        out += '\n';
+        return true;
+    }
+
+public:
+    explicit SessionReplayer(const ReplaySession& s) : session(s) {
+        for (const auto& operation : s.operations) {
+            auto it = std::find_if(stats.begin(), stats.end(), [&](const Stats& st) { return st.name == operation.name; });
+            if (it == stats.end()) { stats.push_back({operation.name, {}, 0, 0}); it = stats.end() - 1; }
+            statIndex.push_back(static_cast<size_t>(it - stats.begin()));
+        }
+    }
+
+    // Runs menu() once over the whole session with std::cin and std::cout
+    // redirected. Returns the number of session lines the menu left unread
+    // (non-zero means it exited early or the session is out of step).
+    template <typename Menu>
+    size_t run(Menu&& menu) {
+        struct Redirect { // Restores the real streams however menu() ends
+            std::streambuf* in; std::streambuf* out; std::ios_base::iostate mask;
+            ~Redirect() { std::cin.exceptions(mask); std::cin.rdbuf(in); std::cout.rdbuf(out); std::cin.clear(); }
+        };
+        op = 0; line = 0; open = false;
+        InputBuf input(*this);
+        Redirect guard{std::cin.rdbuf(&input), std::cout.rdbuf(&output), std::cin.exceptions()};
+        std::cin.clear();
+        std::cin.exceptions(std::ios_base::badbit); // Rethrows ReplayFinished instead of just setting badbit
+        try {
+            menu();
+        } catch (const ReplayFinished&) {
+        }
+        Clock::time_point end = Clock::now();
+        size_t unread = open ? session.operations[op].lines.size() - line : 0;
+        for (size_t i = open ? op + 1 : op; i < session.operations.size(); ++i) unread += session.operations[i].lines.size();
+        closeOperation(end);
+        return unread;
+    }
+
+    void report(std::ostream& out, std::string_view program) const {
+        out.imbue(std::locale::classic());
+        out << std::fixed << std::setprecision(1);
+        out << "program,operation,count,median_ns,p90_ns,max_ns,output_bytes,flushes\n";
+        for (const Stats& s : stats) {
+            if (s.ns.empty()) continue;
+            std::vector<double> sorted = s.ns;
+            std::sort(sorted.begin(), sorted.end());
+            double count = double(sorted.size());
+            out << program << ',' << s.name << ',' << sorted.size() << ',' << sorted[sorted.size() / 2] << ','
+                << sorted[std::min(sorted.size() - 1, sorted.size() * 9 / 10)] << ',' << sorted.back() << ','
+                << double(s.bytes) / count << ',' << double(s.flushes) / count << '\n';
+        }
+        out.flush();
+    }
+};
+
+#endif // SESSION_REPLAY_H
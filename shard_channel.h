@@ -0,0 +1,120 @@
+#ifndef SHARD_CHANNEL_H
+#define SHARD_CHANNEL_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <unistd.h>
+#define SHARD_CHANNEL_SUPPORTED 1
+#endif
+
+// ** Shard channel **
+// Framing for the router <-> worker connection of the sharded mode: a
+// request is one text line, a response is a header line "<status> <length>"
+// followed by exactly length bytes of payload:
+//
+//     router:  x join-event "1004"\n
+//     worker:  ok 0\n
+//
+// It works on any connected stream descriptor (the programs use a
+// socketpair per forked worker; a TCP socket would do as well). Reads are
+// buffered; writes go out whole before returning.
+
+class ShardChannel {
+private:
+    int fd = -1;
+    std::string buffer;   // received but not yet consumed
+    size_t start = 0;
+
+    bool fill() {
+#ifdef SHARD_CHANNEL_SUPPORTED
+        if (start > 0 && start == buffer.size()) { buffer.clear(); start = 0; }
+        char chunk[16384];
+        while (true) {
+            ssize_t n = ::read(fd, chunk, sizeof chunk);
+            if (n > 0) { buffer.append(chunk, static_cast<size_t>(n)); return true; }
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+#else
+        return false;
+#endif
+    }
+
+public:
+    ShardChannel() = default;
+    explicit ShardChannel(int descriptor) : fd(descriptor) {}
+
+    int descriptor() const { return fd; }
+
+    void close() {
+#ifdef SHARD_CHANNEL_SUPPORTED
+        if (fd >= 0) ::close(fd);
+#endif
+        fd = -1;
+    }
+
+    bool writeAll(std::string_view data) {
+#ifdef SHARD_CHANNEL_SUPPORTED
+        while (!data.empty()) {
+            ssize_t n = ::write(fd, data.data(), data.size());
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data.remove_prefix(static_cast<size_t>(n));
+        }
+        return true;
+#else
+        (void)data;
+        return false;
+#endif
+    }
+
+    // A line without its '\n'; false at end of stream
+    bool readLine(std::string& line) {
+        while (true) {
+            size_t newline = buffer.find('\n', start);
+            if (newline != std::string::npos) {
+                line.assign(buffer, start, newline - start);
+                start = newline + 1;
+                return true;
+            }
+            if (!fill()) return false;
+        }
+    }
+
+    bool readExact(size_t length, std::string& out) {
+        while (buffer.size() - start < length)
+            if (!fill()) return false;
+        out.assign(buffer, start, length);
+        start += length;
+        return true;
+    }
+
+    bool sendResponse(std::string_view status, std::string_view payload) {
+        std::string header(status);
+        header += ' ';
+        header += std::to_string(payload.size());
+        header += '\n';
+        return writeAll(header) && writeAll(payload);
+    }
+
+    // False if the stream ended or the header is malformed
+    bool readResponse(std::string& status, std::string& payload) {
+        std::string header;
+        if (!readLine(header)) return false;
+        size_t space = header.find(' ');
+        if (space == std::string::npos) return false;
+        status.assign(header, 0, space);
+        size_t length = 0;
+        for (size_t i = space + 1; i < header.size(); ++i) {
+            if (header[i] < '0' || header[i] > '9') return false;
+            length = length * 10 + size_t(header[i] - '0');
+        }
+        return readExact(length, payload);
+    }
+};
+
+#endif // SHARD_CHANNEL_H
@@ -0,0 +1,363 @@
+#ifndef SHM_CATALOG_H
+#define SHM_CATALOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SHM_CATALOG_SUPPORTED 1
+#endif
+
+// ** Shared-memory event catalog **
+// The primary publishes an immutable snapshot of the event list into a POSIX
+// shared memory object (EMS_CATALOG=/name); other processes on the host map
+// it read-only and look events up in place, without locks or copies.
+//
+// Region: a RegionHeader, then the two slots' areas. A slot holds one
+// catalog image:
+//
+//     CatalogImage | CatalogEvent[count] (sorted by ID) | string bytes
+//
+// where strings are CatalogText {offset, length} relative to the image,
+// never raw pointers, so the image means the same at any mapping address.
+//
+// Publishing writes the slot readers are not directed to, then swaps the
+// active index. Each slot has a sequence number that is odd while the slot
+// is being written (a seqlock): a reader notes it, reads, and accepts what
+// it read only if the number is unchanged, retrying otherwise. Reads of a
+// slot being overwritten may see torn data before the check fails, so
+// CatalogView bounds-checks every offset it follows.
+
+struct CatalogText {
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+struct CatalogEvent {
+    int32_t eventId;
+    uint32_t date;      // Date::packed (year << 9 | month << 5 | day)
+    uint32_t minutes;   // TimeOfDay::minutes
+    uint32_t attendees;
+    CatalogText name, location, category, status, description;
+};
+
+struct CatalogImage {
+    char magic[4];      // "ECAT"
+    uint32_t count;
+    uint64_t version;   // 1 for the first publication, +1 for each after
+    uint64_t publishedMs;
+};
+
+// Read-only access to one catalog image
+class CatalogView {
+private:
+    const char* base = nullptr;
+    size_t length = 0;
+
+    const CatalogImage& image() const { return *reinterpret_cast<const CatalogImage*>(base); }
+
+public:
+    CatalogView() = default;
+    CatalogView(const char* data, size_t size) : base(data), length(size) {}
+
+    bool valid() const {
+        return base && length >= sizeof(CatalogImage) && std::memcmp(image().magic, "ECAT", 4) == 0
+               && image().count <= (length - sizeof(CatalogImage)) / sizeof(CatalogEvent);
+    }
+    uint64_t version() const { return image().version; }
+    uint64_t publishedMs() const { return image().publishedMs; }
+    size_t size() const { return image().count; }
+    const CatalogEvent& operator[](size_t i) const {
+        return reinterpret_cast<const CatalogEvent*>(base + sizeof(CatalogImage))[i];
+    }
+    // Empty for an out-of-range reference (possible only in a torn read)
+    std::string_view text(CatalogText t) const {
+        if (t.offset > length || t.length > length - t.offset) return {};
+        return std::string_view(base + t.offset, t.length);
+    }
+    const CatalogEvent* find(int eventId) const {
+        size_t lo = 0, hi = size();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if ((*this)[mid].eventId < eventId) lo = mid + 1; else hi = mid;
+        }
+        return lo < size() && (*this)[lo].eventId == eventId ? &(*this)[lo] : nullptr;
+    }
+};
+
+// Builds a catalog image. Add events in ascending ID order.
+class CatalogBuilder {
+private:
+    std::string events;
+    std::string strings;
+
+    CatalogText add(std::string_view s) {
+        CatalogText t;
+        t.offset = static_cast<uint32_t>(strings.size()); // Rebased in finish()
+        t.length = static_cast<uint32_t>(s.size());
+        strings.append(s.data(), s.size());
+        return t;
+    }
+
+public:
+    void clear() { events.clear(); strings.clear(); }
+
+    void addEvent(int eventId, uint32_t date, uint32_t minutes, uint32_t attendees, std::string_view name,
+                  std::string_view location, std::string_view category, std::string_view status,
+                  std::string_view description) {
+        CatalogEvent e;
+        e.eventId = eventId;
+        e.date = date;
+        e.minutes = minutes;
+        e.attendees = attendees;
+        e.name = add(name);
+        e.location = add(location);
+        e.category = add(category);
+        e.status = add(status);
+        e.description = add(description);
+        events.append(reinterpret_cast<const char*>(&e), sizeof e);
+    }
+
+    std::string finish(uint64_t version, uint64_t publishedMs) const {
+        CatalogImage header;
+        std::memcpy(header.magic, "ECAT", 4);
+        header.count = static_cast<uint32_t>(events.size() / sizeof(CatalogEvent));
+        header.version = version;
+        header.publishedMs = publishedMs;
+        std::string out(reinterpret_cast<const char*>(&header), sizeof header);
+        out += events;
+        uint32_t stringBase = static_cast<uint32_t>(out.size());
+        for (size_t i = 0; i < header.count; ++i) {
+            auto* e = reinterpret_cast<CatalogEvent*>(&out[sizeof header + i * sizeof(CatalogEvent)]);
+            for (CatalogText* t : {&e->name, &e->location, &e->category, &e->status, &e->description}) t->offset += stringBase;
+        }
+        out += strings;
+        return out;
+    }
+};
+
+namespace shm_catalog_detail {
+struct Slot {
+    std::atomic<uint64_t> seq;      // Odd while the slot is written
+    std::atomic<uint64_t> offset;   // From the start of the region
+    std::atomic<uint64_t> capacity;
+    std::atomic<uint64_t> used;
+};
+struct RegionHeader {
+    char magic[8];                  // "EMSCAT1"
+    std::atomic<uint64_t> size;     // Current size of the region; grows, never shrinks
+    std::atomic<uint32_t> active;   // Slot readers should use
+    Slot slots[2];
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "shared-memory atomics must be lock-free to work across processes");
+constexpr uint64_t kMinSlot = 64 * 1024;
+inline uint64_t alignUp(uint64_t n) { return (n + 63) & ~uint64_t(63); }
+}
+
+// The writing side; one per catalog name
+class ShmCatalogPublisher {
+private:
+    std::string name;
+    int fd = -1;
+    char* base = nullptr;
+    size_t mapped = 0;
+    uint64_t version = 0;
+
+    shm_catalog_detail::RegionHeader* header() const { return reinterpret_cast<shm_catalog_detail::RegionHeader*>(base); }
+
+    bool mapSize(uint64_t size) {
+#ifdef SHM_CATALOG_SUPPORTED
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) return false;
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) return false;
+        if (base) munmap(base, mapped);
+        base = static_cast<char*>(p);
+        mapped = size;
+        return true;
+#else
+        (void)size;
+        return false;
+#endif
+    }
+
+public:
+    ShmCatalogPublisher() = default;
+    ShmCatalogPublisher(const ShmCatalogPublisher&) = delete;
+    ShmCatalogPublisher& operator=(const ShmCatalogPublisher&) = delete;
+    ~ShmCatalogPublisher() { close(); }
+
+    bool isOpen() const { return base != nullptr; }
+    uint64_t lastVersion() const { return version; }
+
+    // Creates (or takes over) the shared memory object; readers that have
+    // it mapped keep working and see the next publication
+    bool open(const std::string& shmName) {
+#ifdef SHM_CATALOG_SUPPORTED
+        close();
+        name = shmName;
+        using namespace shm_catalog_detail;
+        fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0) return false;
+        struct stat st;
+        uint64_t size = fstat(fd, &st) == 0 ? uint64_t(st.st_size) : 0;
+        bool fresh = size < sizeof(RegionHeader);
+        if (fresh) size = alignUp(sizeof(RegionHeader));
+        if (!mapSize(size)) { close(); return false; }
+        if (fresh || std::memcmp(header()->magic, "EMSCAT1", 8) != 0) {
+            std::memset(base, 0, sizeof(RegionHeader)); // No reader can have found the magic yet
+            std::memcpy(header()->magic, "EMSCAT1", 8);
+            header()->size.store(size);
+        } else {
+            // Continue the previous publisher's version numbers
+            const Slot& slot = header()->slots[header()->active.load() & 1];
+            uint64_t offset = slot.offset.load(), used = slot.used.load();
+            CatalogView last(base + offset, used);
+            if (slot.seq.load() != 0 && offset <= mapped && used <= mapped - offset && last.valid()) version = last.version();
+        }
+        return true;
+#else
+        (void)shmName;
+        return false;
+#endif
+    }
+
+    // The object stays behind for readers; unlink() removes it
+    void close() {
+#ifdef SHM_CATALOG_SUPPORTED
+        if (base) munmap(base, mapped);
+        if (fd >= 0) ::close(fd);
+#endif
+        base = nullptr;
+        mapped = 0;
+        fd = -1;
+    }
+
+    void unlink() {
+#ifdef SHM_CATALOG_SUPPORTED
+        if (!name.empty()) shm_unlink(name.c_str());
+#endif
+    }
+
+    // Publishes a CatalogBuilder image; false if the region cannot grow
+    bool publish(const CatalogBuilder& builder, uint64_t publishedMs) {
+        if (!base) return false;
+        using namespace shm_catalog_detail;
+        std::string image = builder.finish(version + 1, publishedMs);
+        uint32_t target = 1 - header()->active.load(std::memory_order_relaxed);
+        Slot& slot = header()->slots[target];
+        // Odd while writing, even when done. A publisher that died mid-write
+        // can leave the slot odd, so round up rather than add.
+        uint64_t writing = slot.seq.load(std::memory_order_relaxed) | 1;
+        slot.seq.store(writing, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        if (image.size() > slot.capacity.load(std::memory_order_relaxed)) {
+            // A new, larger area at the end; the old one is abandoned
+            uint64_t offset = alignUp(header()->size.load());
+            uint64_t capacity = std::max<uint64_t>(kMinSlot, alignUp(image.size() * 2));
+            if (!mapSize(offset + capacity)) {
+                Slot& failed = header()->slots[target];
+                failed.seq.store(writing + 1, std::memory_order_release); // Unchanged contents
+                return false;
+            }
+            header()->size.store(offset + capacity);
+            header()->slots[target].offset.store(offset, std::memory_order_relaxed);
+            header()->slots[target].capacity.store(capacity, std::memory_order_relaxed);
+        }
+        Slot& written = header()->slots[target]; // The header may have moved
+        std::memcpy(base + written.offset.load(std::memory_order_relaxed), image.data(), image.size());
+        written.used.store(image.size(), std::memory_order_relaxed);
+        written.seq.store(writing + 1, std::memory_order_release);
+        header()->active.store(target, std::memory_order_release);
+        ++version;
+        return true;
+    }
+};
+
+// The reading side: maps the catalog read-only
+class ShmCatalogReader {
+private:
+    int fd = -1;
+    const char* base = nullptr;
+    size_t mapped = 0;
+
+    const shm_catalog_detail::RegionHeader* header() const {
+        return reinterpret_cast<const shm_catalog_detail::RegionHeader*>(base);
+    }
+
+    bool remap() {
+#ifdef SHM_CATALOG_SUPPORTED
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(shm_catalog_detail::RegionHeader)) return false;
+        void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) return false;
+        if (base) munmap(const_cast<char*>(base), mapped);
+        base = static_cast<const char*>(p);
+        mapped = size_t(st.st_size);
+        return std::memcmp(header()->magic, "EMSCAT1", 8) == 0;
+#else
+        return false;
+#endif
+    }
+
+public:
+    ShmCatalogReader() = default;
+    ShmCatalogReader(const ShmCatalogReader&) = delete;
+    ShmCatalogReader& operator=(const ShmCatalogReader&) = delete;
+    ~ShmCatalogReader() {
+#ifdef SHM_CATALOG_SUPPORTED
+        if (base) munmap(const_cast<char*>(base), mapped);
+        if (fd >= 0) ::close(fd);
+#endif
+    }
+
+    bool open(const std::string& shmName) {
+#ifdef SHM_CATALOG_SUPPORTED
+        fd = shm_open(shmName.c_str(), O_RDONLY, 0);
+        return fd >= 0 && remap();
+#else
+        (void)shmName;
+        return false;
+#endif
+    }
+
+    // Calls visit(const CatalogView&) on the current catalog until a call
+    // completes without a publication overwriting what it read; visit may
+    // run more than once, so it should only collect into state it resets.
+    // False if nothing has been published or no consistent read succeeded.
+    template <typename Visit>
+    bool read(Visit&& visit) {
+        using namespace shm_catalog_detail;
+        if (!base) return false;
+        for (int attempt = 0; attempt < 10000; ++attempt) {
+            uint32_t active = header()->active.load(std::memory_order_acquire) & 1;
+            const Slot& slot = header()->slots[active];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq == 0) return false; // Never published
+            if (seq & 1) continue;
+            uint64_t offset = slot.offset.load(std::memory_order_relaxed);
+            uint64_t used = slot.used.load(std::memory_order_relaxed);
+            if (offset > mapped || used > mapped - offset) {
+                if (!remap()) return false;
+                continue;
+            }
+            CatalogView view(base + offset, used);
+            bool ok = view.valid();
+            if (ok) visit(static_cast<const CatalogView&>(view));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq) return ok;
+        }
+        return false;
+    }
+};
+
+#endif // SHM_CATALOG_H
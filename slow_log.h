@@ -0,0 +1,334 @@
+#ifndef SLOW_LOG_H
+#define SLOW_LOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <locale>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+// ** Slow-operation log **
+// Operations that take longer than a threshold are written as one JSON line
+// each, with the parameters and phase timings the operation attached:
+//
+//     {"time":"2026-10-18T03:12:45.123Z","op":"deleteUser","thread":1,"ms":412.301,"threshold_ms":100,
+//      "params":{"user":"bob","users":50000},"phases_ms":{"remove":0.012,"saveUsers":412.289}}
+//
+// (one line in the file). Instrumented code marks its parameters and phases
+// on a SlowOp:
+//
+//     SlowOp slow("deleteUser");
+//     slow.text("user", uname);
+//     ... slow.phase("remove");
+//     if (autoSave) { saveUsers(); slow.phase("saveUsers"); }
+//     slow.count("users", users.size());
+//
+// Time after the last phase (1 us or more) is reported as "other".
+// Thresholds come from EMS_SLOW_MS ("<ms>[,<op>=<ms>]...", e.g.
+// "100,loadData=500"; 0 or unset is off) or the "slow-log" batch command;
+// records go to EMS_SLOW_LOG (default slow.log in the startup directory).
+// While off, a SlowOp costs one relaxed load. Submitting a record copies it
+// into a fixed queue under a short lock; a background thread, started by the
+// first record, formats and writes it, so the slow operation never waits on
+// the file. When the queue is full the record is dropped and counted.
+
+class SlowLog {
+public:
+    static constexpr size_t kMaxParams = 6;
+    static constexpr size_t kMaxPhases = 8;
+    static constexpr size_t kTextSize = 48;
+    static constexpr size_t kQueueSize = 256;
+
+    struct Record {
+        const char* op = nullptr;
+        uint64_t wallNs = 0;      // system clock at the end of the operation
+        uint64_t totalNs = 0;
+        uint64_t thresholdNs = 0;
+        uint32_t thread = 0;
+        uint8_t params = 0, phases = 0;
+        struct Param { const char* key; int64_t value; const char* text; } param[kMaxParams];
+        struct Phase { const char* name; uint64_t ns; } phase[kMaxPhases];
+        char text[kTextSize];      // storage for the one text parameter
+    };
+
+    static bool armed() { return state().armed.load(std::memory_order_relaxed); }
+
+    // Threshold for op: its override if set, otherwise the default. The
+    // overrides are read without a lock, so configure the log while no other
+    // thread is running instrumented operations.
+    static uint64_t thresholdNs(const char* op) {
+        State& s = state();
+        for (const auto& entry : s.overrides)
+            if (entry.first == op) return entry.second;
+        return s.defaultNs;
+    }
+
+    // "<ms>[,<op>=<ms>]..."; "off" or "0" clears everything. False (and no
+    // change) if the spec does not parse.
+    static bool configure(std::string_view spec) {
+        uint64_t defaultNs = 0;
+        std::vector<std::pair<std::string, uint64_t>> overrides;
+        if (spec != "off") {
+            while (!spec.empty()) {
+                size_t comma = spec.find(',');
+                std::string_view item = spec.substr(0, comma);
+                spec = comma == std::string_view::npos ? std::string_view() : spec.substr(comma + 1);
+                size_t eq = item.find('=');
+                uint64_t ns;
+                if (!parseMillis(eq == std::string_view::npos ? item : item.substr(eq + 1), ns)) return false;
+                if (eq == std::string_view::npos) defaultNs = ns;
+                else overrides.emplace_back(std::string(item.substr(0, eq)), ns);
+            }
+        }
+        State& s = state();
+        s.defaultNs = defaultNs;
+        s.overrides = std::move(overrides);
+        bool any = defaultNs != 0;
+        for (const auto& entry : s.overrides) any = any || entry.second != 0;
+        s.armed.store(any, std::memory_order_relaxed);
+        return true;
+    }
+
+    static void configureFromEnvironment() {
+        const char* path = std::getenv("EMS_SLOW_LOG");
+        std::string file = path && *path ? path : "slow.log";
+#if defined(__unix__) || defined(__APPLE__)
+        // Relative to where the program started, not to a scratch
+        // directory a benchmark or replay switches to later
+        char cwd[4096];
+        if (file[0] != '/' && getcwd(cwd, sizeof cwd)) file = std::string(cwd) + "/" + file;
+#endif
+        state().path = file;
+        const char* spec = std::getenv("EMS_SLOW_MS");
+        if (spec && *spec && !configure(spec)) std::fprintf(stderr, "Warn: Ignoring EMS_SLOW_MS=%s.\n", spec);
+    }
+
+    // Queues a record for the writer thread; never waits for I/O
+    static void submit(const Record& record) {
+        State& s = state();
+        {
+            std::lock_guard<std::mutex> lock(s.queueLock);
+            if (s.tail - s.head == kQueueSize) { ++s.dropped; return; }
+            s.queue[s.tail++ % kQueueSize] = record;
+            if (!s.writer.joinable()) {
+                s.writer = std::thread(writerLoop);
+                std::atexit(shutdown);
+            }
+        }
+        s.wake.notify_one();
+    }
+
+    // Blocks until every queued record is in the file
+    static void flush() {
+        State& s = state();
+        std::unique_lock<std::mutex> lock(s.queueLock);
+        s.drained.wait(lock, [&] { return s.written == s.tail || !s.writer.joinable(); });
+    }
+
+    static uint64_t dropped() {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.queueLock);
+        return s.dropped;
+    }
+
+    static uint32_t threadNumber() {
+        static std::atomic<uint32_t> next{1};
+        thread_local uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+private:
+    struct State {
+        std::atomic<bool> armed{false};
+        uint64_t defaultNs = 0;
+        std::vector<std::pair<std::string, uint64_t>> overrides;
+        std::string path = "slow.log";
+
+        std::mutex queueLock;
+        std::condition_variable wake, drained;
+        Record queue[kQueueSize];
+        uint64_t head = 0, tail = 0, written = 0, dropped = 0, droppedReported = 0;
+        bool stopping = false;
+        std::thread writer;
+    };
+
+    static State& state() { static State s; return s; }
+
+    // "<digits>[.<digits>]" milliseconds; parsed by hand so the C locale's
+    // decimal separator does not matter
+    static bool parseMillis(std::string_view text, uint64_t& ns) {
+        uint64_t whole = 0, fraction = 0, scale = 1000000;
+        size_t i = 0;
+        for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i) whole = whole * 10 + uint64_t(text[i] - '0');
+        if (i == 0) return false;
+        if (i < text.size() && text[i] == '.') {
+            for (++i; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i)
+                if (scale > 1) { scale /= 10; fraction += uint64_t(text[i] - '0') * scale; }
+        }
+        if (i != text.size()) return false;
+        ns = whole * 1000000 + fraction;
+        return true;
+    }
+
+    static void shutdown() {
+        State& s = state();
+        {
+            std::lock_guard<std::mutex> lock(s.queueLock);
+            s.stopping = true;
+        }
+        s.wake.notify_one();
+        if (s.writer.joinable()) s.writer.join();
+    }
+
+    static void writerLoop() {
+        State& s = state();
+        std::ofstream out(s.path, std::ios::app);
+        out.imbue(std::locale::classic());
+        std::unique_lock<std::mutex> lock(s.queueLock);
+        while (true) {
+            s.wake.wait(lock, [&] { return s.head != s.tail || s.stopping; });
+            if (s.head == s.tail && s.stopping) break;
+            Record record = s.queue[s.head++ % kQueueSize];
+            uint64_t lost = s.dropped - s.droppedReported;
+            s.droppedReported = s.dropped;
+            lock.unlock();
+            if (lost) out << "{\"dropped\":" << lost << "}\n";
+            write(out, record);
+            out.flush();
+            lock.lock();
+            ++s.written;
+            s.drained.notify_all();
+        }
+    }
+
+    static void writeMillis(std::ostream& out, uint64_t ns) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof buffer, "%llu.%03llu", static_cast<unsigned long long>(ns / 1000000),
+                      static_cast<unsigned long long>(ns / 1000 % 1000));
+        out << buffer;
+    }
+
+    static void writeString(std::ostream& out, const char* s) {
+        out << '"';
+        for (; *s; ++s) {
+            unsigned char c = static_cast<unsigned char>(*s);
+            if (c == '"' || c == '\\') out << '\\' << *s;
+            else if (c < 0x20) { char escaped[8]; std::snprintf(escaped, sizeof escaped, "\\u%04x", c); out << escaped; }
+            else out << *s;
+        }
+        out << '"';
+    }
+
+    static void write(std::ostream& out, const Record& r) {
+        time_t seconds = static_cast<time_t>(r.wallNs / 1000000000);
+        tm utc;
+#ifdef _WIN32
+        gmtime_s(&utc, &seconds);
+#else
+        gmtime_r(&seconds, &utc);
+#endif
+        char stamp[64];
+        std::snprintf(stamp, sizeof stamp, "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", utc.tm_year + 1900, utc.tm_mon + 1,
+                      utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, static_cast<int>(r.wallNs / 1000000 % 1000));
+        out << "{\"time\":\"" << stamp << "\",\"op\":";
+        writeString(out, r.op);
+        out << ",\"thread\":" << r.thread << ",\"ms\":";
+        writeMillis(out, r.totalNs);
+        out << ",\"threshold_ms\":";
+        writeMillis(out, r.thresholdNs);
+        out << ",\"params\":{";
+        for (size_t i = 0; i < r.params; ++i) {
+            if (i) out << ',';
+            writeString(out, r.param[i].key);
+            out << ':';
+            if (r.param[i].text) writeString(out, r.text);
+            else out << r.param[i].value;
+        }
+        out << "},\"phases_ms\":{";
+        for (size_t i = 0; i < r.phases; ++i) {
+            if (i) out << ',';
+            writeString(out, r.phase[i].name);
+            out << ':';
+            writeMillis(out, r.phase[i].ns);
+        }
+        out << "}}\n";
+    }
+};
+
+// Times the enclosing scope and logs it through SlowLog if it ran past the
+// threshold. Parameter keys, phase names and the operation name must be
+// string literals.
+class SlowOp {
+private:
+    using Clock = std::chrono::steady_clock;
+    bool armed;
+    Clock::time_point start, mark;
+    SlowLog::Record record;
+
+    static uint64_t nanos(Clock::time_point from, Clock::time_point to) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+    }
+
+public:
+    explicit SlowOp(const char* op) : armed(SlowLog::armed()) {
+        if (!armed) return;
+        record.op = op;
+        start = mark = Clock::now();
+    }
+
+    SlowOp(const SlowOp&) = delete;
+    SlowOp& operator=(const SlowOp&) = delete;
+
+    void count(const char* key, int64_t value) {
+        if (armed && record.params < SlowLog::kMaxParams) record.param[record.params++] = {key, value, nullptr};
+    }
+
+    // One text parameter per operation, truncated to fit
+    void text(const char* key, std::string_view value) {
+        if (!armed || record.params == SlowLog::kMaxParams) return;
+        size_t n = std::min(value.size(), SlowLog::kTextSize - 1);
+        std::memcpy(record.text, value.data(), n);
+        record.text[n] = '\0';
+        record.param[record.params++] = {key, 0, record.text};
+    }
+
+    // Ends the current phase: the time since the previous phase (or the
+    // start) is attributed to name
+    void phase(const char* name) {
+        if (!armed) return;
+        Clock::time_point now = Clock::now();
+        if (record.phases < SlowLog::kMaxPhases) record.phase[record.phases++] = {name, nanos(mark, now)};
+        mark = now;
+    }
+
+    ~SlowOp() {
+        if (!armed) return;
+        Clock::time_point end = Clock::now();
+        record.totalNs = nanos(start, end);
+        record.thresholdNs = SlowLog::thresholdNs(record.op);
+        if (record.thresholdNs == 0 || record.totalNs < record.thresholdNs) return;
+        if (record.phases && record.phases < SlowLog::kMaxPhases && nanos(mark, end) >= 1000)
+            record.phase[record.phases++] = {"other", nanos(mark, end)};
+        record.thread = SlowLog::threadNumber();
+        record.wallNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        SlowLog::submit(record);
+    }
+};
+
+#endif // SLOW_LOG_H
@@ -0,0 +1,113 @@
+#ifndef SYNTHETIC_DATA_H
+#define SYNTHETIC_DATA_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// ** Synthetic data building blocks **
+// Deterministic random sources for the dataset generator (--generate) and
+// the benchmarks. Everything is derived from one 64-bit seed with our own
+// generator and samplers rather than std::*_distribution, whose output
+// differs between standard libraries, so a seed names the same dataset on
+// every build.
+
+// SplitMix64: tiny, fast, and good enough for test data
+class SeededRandom {
+private:
+    uint64_t state;
+
+public:
+    explicit SeededRandom(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, n), n > 0: the high 64 bits of next() * n (the bias is
+    // far below what test data can show)
+    size_t below(size_t n) {
+        uint64_t a = next(), b = n;
+        uint64_t aLo = a & 0xFFFFFFFFu, aHi = a >> 32, bLo = b & 0xFFFFFFFFu, bHi = b >> 32;
+        uint64_t lh = aLo * bHi, hl = aHi * bLo;
+        uint64_t mid = ((aLo * bLo) >> 32) + (lh & 0xFFFFFFFFu) + (hl & 0xFFFFFFFFu);
+        return static_cast<size_t>(aHi * bHi + (lh >> 32) + (hl >> 32) + (mid >> 32));
+    }
+
+    // Uniform in [0, 1)
+    double unit() { return double(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    bool chance(double p) { return unit() < p; }
+
+    // Independent stream for one part of a dataset, so adding draws to one
+    // part does not shift the others
+    SeededRandom fork(uint64_t salt) { return SeededRandom(next() ^ (salt * 0xD1B54A32D192ED03ull)); }
+};
+
+// ** ZipfSampler **
+// Ranks 1..n with P(k) proportional to 1/k^s, in O(1) time and memory via
+// rejection-inversion (Hörmann & Derflinger, 1996), so it works for the
+// 10^7-element popularity tables a full-scale dataset needs.
+class ZipfSampler {
+private:
+    double s;
+    double n;
+    double hIntegralX1, hIntegralN, sTerm;
+
+    static double helper1(double x) { return std::fabs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x)); }
+    static double helper2(double x) { return std::fabs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x)); }
+    double h(double x) const { return std::exp(-s * std::log(x)); }
+    double hIntegral(double x) const { double lx = std::log(x); return helper2((1 - s) * lx) * lx; }
+    double hIntegralInverse(double x) const {
+        double t = x * (1 - s);
+        if (t < -1) t = -1;
+        return std::exp(helper1(t) * x);
+    }
+
+public:
+    ZipfSampler(size_t count, double exponent) : s(exponent), n(double(count)) {
+        hIntegralX1 = hIntegral(1.5) - 1;
+        hIntegralN = hIntegral(n + 0.5);
+        sTerm = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+    }
+
+    // Rank in [0, count): 0 is the most popular
+    size_t operator()(SeededRandom& rng) const {
+        while (true) {
+            double u = hIntegralN + rng.unit() * (hIntegralX1 - hIntegralN);
+            double x = hIntegralInverse(u);
+            double k = std::floor(x + 0.5);
+            if (k < 1) k = 1; else if (k > n) k = n;
+            if (k - x <= sTerm || u >= hIntegral(k + 0.5) - h(k)) return static_cast<size_t>(k) - 1;
+        }
+    }
+};
+
+// Pick from a fixed word list
+template <size_t N>
+std::string_view pick(SeededRandom& rng, const std::string_view (&words)[N]) { return words[rng.below(N)]; }
+
+// Scrambles 0..n-1 into a fixed pseudo-random order (an odd multiplier
+// modulo a power of two, folded into range by cycle walking), so Zipf rank
+// 0 is not always record 0
+class RankShuffle {
+private:
+    uint64_t n, mask, mul, add;
+
+public:
+    RankShuffle(size_t count, SeededRandom& rng) : n(count), mask(1), mul(rng.next() | 1), add(rng.next()) {
+        while (mask < n) mask <<= 1;
+        --mask;
+    }
+    size_t operator()(size_t rank) const {
+        uint64_t x = rank;
+        do { x = (x * mul + add) & mask; } while (x >= n);
+        return static_cast<size_t>(x);
+    }
+};
+
+#endif // SYNTHETIC_DATA_H
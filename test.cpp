@@ -2,11 +2,47 @@
 #include <vector>
 #include <string>
 #include <fstream>
-#include <sstream>
 #include <algorithm> // For std::transform, std::find, std::remove_if, std::find_if
 #include <limits>    // For std::numeric_limits
 #include <map>       // For inventory allocation in events
 #include <locale>    // For std::locale
+#include "output_buffer.h" // Buffered page/file rendering
+#include "command_script.h" // Batch mode tokenizer
+#include "record_schema.h"  // Field descriptors -> text/binary record codecs
+#include "csv_scanner.h"    // Quote-aware SIMD record splitter for data files
+#include "date_time.h"      // Packed Date/TimeOfDay with constexpr parsing
+#include <memory>
+#include <unordered_map>
+#include "alloc_counter.h"  // Per-thread heap allocation counts (--alloc-check)
+#include "scratch_arena.h"  // Per-request pmr arena for temporaries
+#include "bench_harness.h"  // Timing loop and CSV output for --bench
+#include "synthetic_data.h" // Seeded RNG and Zipf sampling for --generate
+#include "session_replay.h" // Scripted menu sessions with per-operation timing (--replay)
+#include "latency_histogram.h" // Per-thread HDR latency histograms for core operations
+#include "trace_spans.h"     // Chrome trace spans in per-thread rings (EMS_TRACE, "trace")
+#include "sampling_profiler.h" // SIGPROF stack sampler with folded output (EMS_PROFILE, "profile")
+#include "slow_log.h"        // Operations over a threshold, logged off-thread (EMS_SLOW_MS, "slow-log")
+#include "audit_log.h"       // Binary audit trail of mutations (audit.bin, --audit-decode)
+#include "journal.h"         // Record-level change journal for read replicas (EMS_JOURNAL, --replica)
+#include "shard_channel.h"   // Router <-> shard worker framing (--shards)
+#include "write_behind.h"    // Shared file-writer threads for tenant stores (--tenants)
+#include "shm_catalog.h"     // Seqlocked event catalog in shared memory (EMS_CATALOG, --catalog)
+#include <filesystem>
+#include <sstream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <deque>
+#include <ctime>
+#include <iomanip>
+#include <cctype>
+#include <cerrno>
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 // Forward declarations
 class User;
@@ -17,36 +53,76 @@ class Attendee;
 class InventoryItem;
 class System;
 
+// --- Latency Operations ---
+// Recorded with LatencyScope; reported by the "latency" batch command and
+// written to latency.txt when the program exits.
+namespace latency_op {
+const int login = LatencyStats::operation("login");
+const int registerUser = LatencyStats::operation("register-user");
+const int registerEvent = LatencyStats::operation("register-event");
+const int cancelRegistration = LatencyStats::operation("cancel-registration");
+const int checkIn = LatencyStats::operation("check-in");
+const int searchName = LatencyStats::operation("search-name");
+const int searchDates = LatencyStats::operation("search-dates");
+const int load = LatencyStats::operation("load");
+const int saveUsers = LatencyStats::operation("save-users");
+const int saveEvents = LatencyStats::operation("save-events");
+const int saveInventory = LatencyStats::operation("save-inventory");
+const int saveAttendees = LatencyStats::operation("save-attendees");
+const int saveRegistrations = LatencyStats::operation("save-registrations");
+}
+
 // --- Enums ---
 enum class Role { ADMIN, REGULAR_USER, NONE };
 enum class EventStatus { UPCOMING, ONGOING, COMPLETED, CANCELED };
 
 // --- Helper Functions ---
 
-// Function to convert string to lowercase
-std::string toLower(std::string s) {
-    std::transform(s.begin(), s.end(), s.begin(),
-                   [](unsigned char c){ return std::tolower(c); });
-    return s;
+// Case-insensitive comparisons without building lowercase copies
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) return false;
+    return true;
+}
+bool containsIgnoreCase(std::string_view haystack, std::string_view needle) {
+    if (needle.size() > haystack.size()) return false;
+    for (size_t i = 0; i + needle.size() <= haystack.size(); ++i)
+        if (equalsIgnoreCase(haystack.substr(i, needle.size()), needle)) return true;
+    return false;
 }
 
-// Function to get validated string input (ensures not empty)
-std::string getStringInput(const std::string& prompt) {
-    std::string input;
+// Read trimmed lines into input until one is not empty (any string type, so
+// the line can live in a request's scratch arena)
+template <typename String>
+void readNonEmptyLine(std::string_view prompt, String& input) {
     while (true) {
         std::cout << prompt;
         std::getline(std::cin, input);
         input.erase(0, input.find_first_not_of(" \t\n\r\f\v"));
         input.erase(input.find_last_not_of(" \t\n\r\f\v") + 1);
         if (!input.empty()) {
-            return input;
+            return;
         }
         std::cout << "Input cannot be empty. Please try again.\n";
     }
 }
 
+// Function to get validated string input (ensures not empty)
+std::string getStringInput(std::string_view prompt) {
+    std::string input;
+    readNonEmptyLine(prompt, input);
+    return input;
+}
+// Same, for input that is only needed during the current request
+std::pmr::string getStringInput(std::string_view prompt, ScratchArena& scratch) {
+    std::pmr::string input(scratch.resource());
+    readNonEmptyLine(prompt, input);
+    return input;
+}
+
 // Function to get validated integer input
-int getIntInput(const std::string& prompt) {
+int getIntInput(std::string_view prompt) {
     int input;
     while (true) {
         std::cout << prompt;
@@ -62,7 +138,7 @@ int getIntInput(const std::string& prompt) {
 }
 
 // Function to get validated positive integer input
-int getPositiveIntInput(const std::string& prompt) {
+int getPositiveIntInput(std::string_view prompt) {
     int input;
     while (true) {
         input = getIntInput(prompt);
@@ -73,36 +149,39 @@ int getPositiveIntInput(const std::string& prompt) {
     }
 }
 
-// Basic date validation (format-MM-DD)
-bool isValidDate(const std::string& date) {
-    if (date.length() != 10) return false;
-    if (date[4] != '-' || date[7] != '-') return false;
-    try {
-        int year = std::stoi(date.substr(0, 4));
-        int month = std::stoi(date.substr(5, 2));
-        int day = std::stoi(date.substr(8, 2));
-        if (year < 1900 || year > 2100) return false;
-        if (month < 1 || month > 12) return false;
-        if (day < 1 || day > 31) return false;
-    } catch (const std::exception&) {
-        return false;
-    }
-    return true;
+// Render one record through its schema into a string (save paths append to
+// the file buffer directly instead)
+template <typename T>
+std::string recordToString(const T& rec) {
+    static thread_local OutputBuffer buf;
+    buf.clear();
+    appendText(buf, rec);
+    return std::string(buf.view());
 }
 
-// Basic time validation (format HH:MM - 24-hour)
-bool isValidTime(const std::string& time) {
-    if (time.length() != 5) return false;
-    if (time[2] != ':') return false;
-     try {
-        int hour = std::stoi(time.substr(0, 2));
-        int minute = std::stoi(time.substr(3, 2));
-        if (hour < 0 || hour > 23) return false;
-        if (minute < 0 || minute > 59) return false;
-    } catch (const std::exception&) {
-        return false;
+// Split a single text record into raw fields (fromString wrappers)
+const CsvFields& splitRecord(std::string_view line) {
+    static thread_local CsvFields fields;
+    CsvScanner scanner(line);
+    if (!scanner.next(fields)) fields.clear();
+    return fields;
+}
+
+// Read a whole data file and hand each record's raw fields to onRecord.
+// Records it rejects (by throwing) are reported and skipped.
+template <typename OnRecord>
+void forEachRecordInFile(const std::string& path, OnRecord onRecord) {
+    std::string buffer;
+    if (!readWholeFile(path, buffer)) return;
+    CsvScanner scanner(buffer);
+    CsvFields fields;
+    while (scanner.next(fields)) {
+        try {
+            onRecord(fields);
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: Skipping record in " << path << " (" << e.what() << "): '" << scanner.recordText() << "'\n";
+        }
     }
-    return true;
 }
 
 
@@ -117,21 +196,29 @@ protected:
     int userId;
     static int nextUserId;
 
+    explicit User(Role r) : role(r), userId(0) {} // Blank record for fromString to fill
+
 public:
     User(std::string uname, std::string pwd, Role r);
     User(int id, std::string uname, std::string pwd, Role r);
     virtual ~User();
 
-    std::string getUsername() const { return username; }
-    std::string getPassword() const { return password; }
+    static constexpr auto schema() {
+        return makeSchema(field("id", &User::userId), field("username", &User::username),
+                          field("password", &User::password), field("role", &User::role));
+    }
+
+    const std::string& getUsername() const { return username; }
+    const std::string& getPassword() const { return password; }
     Role getRole() const { return role; }
     int getUserId() const { return userId; }
 
-    void setPassword(const std::string& newPassword);
+    void setPassword(std::string_view newPassword);
 
     virtual void displayMenu(System& sys) = 0; // Pure virtual
     virtual std::string toString() const;
     static User* fromString(const std::string& str); // Definition after Admin/RegularUser
+    static User* fromFields(const CsvFields& fields);
     static void initNextId(int id) { if (id >= nextUserId) nextUserId = id + 1;}
 };
 int User::nextUserId = 1;
@@ -144,6 +231,8 @@ public:
     Admin(int id, std::string uname, std::string pwd);
     void displayMenu(System& sys) override; // Definition moved out
 private:
+    friend class User;
+    Admin() : User(Role::ADMIN) {}
     void adminUserManagementMenu(System& sys);
     void adminEventManagementMenu(System& sys);
     void adminAttendeeManagementMenu(System& sys);
@@ -157,28 +246,74 @@ public:
     RegularUser(std::string uname, std::string pwd);
     RegularUser(int id, std::string uname, std::string pwd);
     void displayMenu(System& sys) override; // Definition moved out
+private:
+    friend class User;
+    RegularUser() : User(Role::REGULAR_USER) {}
 };
 
 
+// ** IdClass **
+// The IDs a process may hand out: those congruent to residue modulo stride.
+// A shard worker allocates event and attendee IDs from its own class, so IDs
+// never collide between shards and an event's shard follows from its ID.
+// Unsharded, every ID qualifies.
+struct IdClass {
+    int stride = 1;
+    int residue = 0;
+    // The smallest ID >= id in this class
+    int align(int id) const {
+        int offset = ((id - residue) % stride + stride) % stride;
+        return offset == 0 ? id : id + stride - offset;
+    }
+};
+
 // ** Attendee Class **
+// A person's profile, stored once however many events they attend. Their
+// registrations live in System's registration table.
 class Attendee {
 public:
     int attendeeId;
     std::string name;
     std::string contactInfo;
-    int eventIdRegisteredFor;
-    bool isCheckedIn;
+    int userId; // Linked login account, 0 if none
     static int nextAttendeeId;
+    static IdClass idClass;
 
-    Attendee(std::string n, std::string contact, int eventId);
-    Attendee(int id, std::string n, std::string contact, int eventId, bool checkedInStatus);
-    void checkIn();
-    void displayDetails() const;
+    Attendee(std::string n, std::string contact, int linkedUserId = 0);
+    Attendee(int id, std::string n, std::string contact, int linkedUserId);
+    static constexpr auto schema() {
+        return makeSchema(field("id", &Attendee::attendeeId), field("name", &Attendee::name),
+                          field("contact", &Attendee::contactInfo), field("userId", &Attendee::userId));
+    }
+    void displayDetails(OutputBuffer& out) const;
     std::string toString() const;
     static Attendee fromString(const std::string& str);
-    static void initNextId(int id) { if (id >= nextAttendeeId) nextAttendeeId = id + 1;}
+    static Attendee fromFields(const CsvFields& fields);
+    static void initNextId(int id) { if (id >= nextAttendeeId) nextAttendeeId = idClass.align(id + 1);}
+private:
+    Attendee() : attendeeId(0), userId(0) {} // Blank record for fromString
 };
 int Attendee::nextAttendeeId = 1;
+IdClass Attendee::idClass;
+
+// ** Registration **
+// One attendee's registration for one event (registrations.txt).
+struct Registration {
+    static constexpr uint8_t CHECKED_IN = 1;
+    int attendeeId = 0;
+    int eventId = 0;
+    uint8_t flags = 0;
+
+    static constexpr auto schema() {
+        return makeSchema(field("attendeeId", &Registration::attendeeId), field("eventId", &Registration::eventId),
+                          field("flags", &Registration::flags));
+    }
+    bool isCheckedIn() const { return flags & CHECKED_IN; }
+    // (attendee, event) as one 64-bit index key
+    static uint64_t key(int attendeeId, int eventId) {
+        return (uint64_t(uint32_t(attendeeId)) << 32) | uint32_t(eventId);
+    }
+};
 
 // ** InventoryItem Class **
 class InventoryItem {
@@ -192,14 +327,22 @@ public:
 
     InventoryItem(std::string n, int qty, std::string desc);
     InventoryItem(int id, std::string n, int totalQty, int allocQty, std::string desc);
+    static constexpr auto schema() {
+        return makeSchema(field("id", &InventoryItem::itemId), field("name", &InventoryItem::name),
+                          field("total", &InventoryItem::totalQuantity), field("allocated", &InventoryItem::allocatedQuantity),
+                          field("description", &InventoryItem::description));
+    }
     int getAvailableQuantity() const;
     bool allocate(int quantityToAllocate);
     bool deallocate(int quantityToDeallocate);
     void setTotalQuantity(int newTotalQuantity);
-    void displayDetails() const;
+    void displayDetails(OutputBuffer& out) const;
     std::string toString() const;
     static InventoryItem fromString(const std::string& str);
+    static InventoryItem fromFields(const CsvFields& fields);
     static void initNextId(int id) { if (id >= nextItemId) nextItemId = id + 1;}
+private:
+    InventoryItem() : itemId(0), totalQuantity(0), allocatedQuantity(0) {} // Blank record for fromString
 };
 int InventoryItem::nextItemId = 1;
 
@@ -208,55 +351,107 @@ class Event {
 public:
     int eventId;
     std::string name;
-    std::string date;
-    std::string time;
+    Date date;
+    TimeOfDay time;
     std::string location;
     std::string description;
     std::string category;
     EventStatus status;
-    std::vector<int> attendeeIds;
+    RoaringBitmap attendeeIds; // Compressed set; see the audience queries on System
     std::map<int, int> allocatedInventory;
     static int nextEventId;
+    static IdClass idClass;
 
-    Event(std::string n, std::string d, std::string t, std::string loc, std::string desc, std::string cat);
-    Event(int id, std::string n, std::string d, std::string t, std::string loc,
+    Event(std::string n, Date d, TimeOfDay t, std::string loc, std::string desc, std::string cat);
+    Event(int id, std::string n, Date d, TimeOfDay t, std::string loc,
           std::string desc, std::string cat, EventStatus stat);
+    static constexpr auto schema() {
+        return makeSchema(field("id", &Event::eventId), field("name", &Event::name), field("date", &Event::date),
+                          field("time", &Event::time), field("location", &Event::location),
+                          field("description", &Event::description), field("category", &Event::category),
+                          field("status", &Event::status), field("attendees", &Event::attendeeIds),
+                          field("inventory", &Event::allocatedInventory));
+    }
     void addAttendee(int attendeeId);
     void removeAttendee(int attendeeId);
     void allocateInventoryItem(int itemId, int quantity);
     int deallocateInventoryItem(int itemId, int quantityToDeallocate);
-    std::string getStatusString() const;
-    void displayDetails(const System& sys) const; // Definition after System
+    const char* getStatusString() const;
+    void displayDetails(const System& sys, OutputBuffer& out) const; // Definition after System
     std::string attendeesToString() const;
     std::string inventoryToString() const;
     std::string toString() const;
     static Event fromString(const std::string& str);
-    static void initNextId(int id) { if (id >= nextEventId) nextEventId = id + 1;}
+    static Event fromFields(const CsvFields& fields);
+    static void initNextId(int id) { if (id >= nextEventId) nextEventId = idClass.align(id + 1);}
+private:
+    Event() : eventId(0), status(EventStatus::UPCOMING) {} // Blank record for fromString
 };
 int Event::nextEventId = 1;
+IdClass Event::idClass;
 
 // ** System Class **
 class System {
 private:
     void seedInitialData(); // DECLARATION - Definition moved out
+    friend int runAllocationCheck(); // Seeds the same data the menus start from
+    friend class TenantHost;         // Seeds new tenant stores
 
 public:
     std::vector<User*> users;
+    // Username -> user. Keys view each User's own username, which never
+    // changes while the User is alive, so lookups by string_view allocate nothing.
+    std::unordered_map<std::string_view, User*> userIndex;
     std::vector<Event> events;
     std::vector<InventoryItem> inventory;
-    std::vector<Attendee> allAttendees;
+    std::vector<Attendee> allAttendees;             // Person table
+    std::unordered_map<int, size_t> attendeeIndex;  // attendeeId -> slot in allAttendees
+    std::unordered_map<int, int> attendeeByUser;    // userId -> attendeeId
+    // Registration table, indexed by (attendee, event), by attendee
+    // (eventsByAttendee) and by event (Event::attendeeIds)
+    std::vector<Registration> registrations;
+    std::unordered_map<uint64_t, size_t> registrationIndex;
+    std::unordered_map<int, RoaringBitmap> eventsByAttendee;
     User* currentUser;
+    mutable OutputBuffer pageBuffer; // Listings are rendered here and written in one go
+    OutputBuffer fileBuffer;         // save* functions render whole files here
+    std::unique_ptr<ScratchArena> ownScratch;
+    ScratchArena& scratch;           // Temporaries of the current menu action or batch command (may be shared)
+    bool autoSave = true;            // Off in batch mode: files are written once at the end
+    bool replica = false;            // Fed from a primary's journal: never loads or saves files
+    JournalWriter journal;           // Record-level changes for replicas (EMS_JOURNAL)
+    JournalWriter history;           // Changes since the last checkpoint (EMS_HISTORY)
+    std::string historyDir;          // Absolute; empty if history is off
+    uint64_t lastCheckpointMs = 0;
+    ShmCatalogPublisher catalog;     // Event list in shared memory for local readers (EMS_CATALOG)
+    bool catalogStale = false;
+    std::string dataDir;             // Prefix of the data file paths: "" (current directory) or "<dir>/"
+    WriteBehindPool* writeBehind = nullptr; // If set, saves are handed to these shared writer threads
 
     const std::string USERS_FILE = "users.txt";
     const std::string EVENTS_FILE = "events.txt";
     const std::string INVENTORY_FILE = "inventory.txt";
     const std::string ATTENDEES_FILE = "attendees.txt";
-
-    System() : currentUser(nullptr) {}
+    const std::string REGISTRATIONS_FILE = "registrations.txt";
+    // The same under dataDir, built once so that saving does not allocate
+    const std::string usersPath = dataDir + USERS_FILE;
+    const std::string eventsPath = dataDir + EVENTS_FILE;
+    const std::string inventoryPath = dataDir + INVENTORY_FILE;
+    const std::string attendeesPath = dataDir + ATTENDEES_FILE;
+    const std::string registrationsPath = dataDir + REGISTRATIONS_FILE;
+
+    System() : System(std::string()) {}
+    // A store whose files live in directory; with sharedScratch, requests
+    // borrow that arena instead of allocating one per System
+    explicit System(const std::string& directory, ScratchArena* sharedScratch = nullptr)
+        : currentUser(nullptr), ownScratch(sharedScratch ? nullptr : std::make_unique<ScratchArena>()),
+          scratch(sharedScratch ? *sharedScratch : *ownScratch),
+          dataDir(directory.empty() || directory.back() == '/' ? directory : directory + "/") {}
     ~System();
 
     void loadData();
     void saveData();
+    void clearData(); // Drop everything in memory (files are untouched)
     void loadUsers(); // Definition after Admin/RegularUser & User::fromString
     void saveUsers();
     void loadEvents();
@@ -264,30 +459,53 @@ public:
     void loadInventory();
     void saveInventory();
     void loadAttendees();
+    void loadRegistrations();
     void saveAttendees();
+    void saveRegistrations();
+    void writeDataFile(const std::string& path); // fileBuffer -> path
 
-    bool usernameExists(const std::string& username) const;
-    void createUserAccount(const std::string& uname, const std::string& pwd, Role role); // Definition after Admin/RegularUser
+    void addUser(User* user);
+    bool usernameExists(std::string_view username) const;
+    bool createUserAccount(const std::string& uname, const std::string& pwd, Role role); // Definition after Admin/RegularUser
     void publicRegisterNewUser(); // Definition after Admin/RegularUser
-    void deleteUserAccount(const std::string& uname);
-    User* findUserByUsername(const std::string& uname);
-    const User* findUserByUsername(const std::string& uname) const;
+    bool deleteUserAccount(std::string_view uname);
+    User* findUserByUsername(std::string_view uname);
+    const User* findUserByUsername(std::string_view uname) const;
     void listAllUsers() const;
 
     bool login();
+    bool login(std::string_view uname, std::string_view pwd);
     void logout();
 
     Event* findEventById(int eventId);
     const Event* findEventById(int eventId) const;
     void createEvent();
+    bool createEvent(std::string_view name, std::string_view date, std::string_view time,
+                     std::string_view loc, std::string_view desc, std::string_view cat);
     void viewAllEvents(bool adminView = false) const;
     void searchEventsByNameOrDate() const;
+    // Search results live in the scratch arena of the current request
+    std::pmr::vector<const Event*> findEventsBetween(Date from, Date to) const;
+    std::pmr::vector<const Event*> findEventsByName(std::string_view keyword) const;
+    void showEventList(const std::pmr::vector<const Event*>& found) const;
     void editEventDetails();
     void deleteEvent();
     void updateEventStatus();
 
     Attendee* findAttendeeInMasterList(int attendeeId);
     const Attendee* findAttendeeInMasterList(int attendeeId) const;
+    Attendee& addAttendee(Attendee attendee);
+    Attendee& profileForUser(const User& user); // Created on first use
+    Registration* findRegistration(int attendeeId, int eventId);
+    bool addRegistration(int attendeeId, int eventId, uint8_t flags = 0);
+    bool removeRegistration(int attendeeId, int eventId);
+    bool checkIn(int attendeeId, int eventId);
+    void updateContactInfo(int attendeeId, std::string_view contact);
+    // Audience queries: set algebra over the events' attendee bitmaps
+    RoaringBitmap attendeesOfEvent(int eventId) const;
+    RoaringBitmap attendeesOfCategory(std::string_view category) const;
+    RoaringBitmap evaluateAudience(const CommandLine& cmd, size_t first) const;
+    void showAudience(const RoaringBitmap& audience) const;
     void registerAttendeeForEvent();
     void cancelOwnRegistration();
     void viewAttendeeListsPerEvent() const;
@@ -297,8 +515,8 @@ public:
 
     InventoryItem* findInventoryItemById(int itemId);
     const InventoryItem* findInventoryItemById(int itemId) const;
-    InventoryItem* findInventoryItemByName(const std::string& name);
-    const InventoryItem* findInventoryItemByName(const std::string& name) const;
+    InventoryItem* findInventoryItemByName(std::string_view name);
+    const InventoryItem* findInventoryItemByName(std::string_view name) const;
     void addInventoryItem();
     void updateInventoryItemDetails();
     void viewAllInventoryItems() const;
@@ -310,6 +528,51 @@ public:
     void exportAllInventoryDataToFile() const;
 
     void run(); // Definition after Admin/RegularUser displayMenu
+    int runScript(std::istream& in); // Non-interactive batch mode
+    bool executeCommand(const CommandLine& cmd);
+
+    // Journal shipping: the primary appends every change to EMS_JOURNAL
+    // (starting with a snapshot); a replica applies it and serves reads
+    void openJournalFromEnvironment();
+    // (journalRecord/journalKey also feed the history journal below)
+    template <typename T>
+    void journalRecord(std::string_view kind, const T& rec) {
+        auto write = [&](OutputBuffer& out) { appendText(out, rec); };
+        if (journal.isOpen()) journal.append(kind, write);
+        if (history.isOpen()) history.append(kind, write);
+        noteChange(kind);
+    }
+    void journalKey(std::string_view kind, int a, int b = 0);
+    void applyJournalEntry(const JournalEntry& entry);
+    int runReplica(const std::string& journalPath, int pollMs, std::istream& in);
+
+    // Point-in-time restore: EMS_HISTORY holds checkpoints (full snapshots),
+    // each followed by the journal of the changes made after it
+    static constexpr uint64_t kCheckpointEvery = 5000; // Journal entries per checkpoint
+    void openHistoryFromEnvironment();
+    void checkpoint();
+    void maybeCheckpoint() { if (history.isOpen() && history.lastSeq() >= kCheckpointEvery) checkpoint(); }
+
+    // Shared-memory catalog: the event list, republished after each request
+    // that changed events or registrations
+    void openCatalogFromEnvironment();
+    void publishCatalog();
+    void noteChange(std::string_view kind) {
+        if (catalog.isOpen() && (kind == "event" || kind == "reg" || kind == "reg-")) catalogStale = true;
+    }
+    // After each menu action or batch command
+    void afterRequest() {
+        maybeCheckpoint();
+        if (catalogStale) publishCatalog();
+    }
+    static int restoreToTime(const std::string& historyPath, uint64_t timeMs);
+
+    // Sharding: events (with their registrations) split across worker
+    // processes by event ID, behind a router that reads batch commands
+    static int shardOf(int eventId, int shards) { return (eventId % shards + shards) % shards; }
+    void writeShard(const std::string& dir, int shard, int shards);
+    int runShardWorker(int shard, int shards, ShardChannel& channel);
+    static int runShardRouter(int shards, std::istream& in);
     void updateCurrentLoggedInUserContactInfo();
 };
 
@@ -326,20 +589,17 @@ User::User(int id, std::string uname, std::string pwd, Role r)
 }
 User::~User() {}
 
-void User::setPassword(const std::string& newPassword) {
+void User::setPassword(std::string_view newPassword) {
     if (newPassword.length() < 6) {
         std::cout << "Password must be at least 6 characters long.\n";
         return;
     }
     password = newPassword;
+    AuditLog::record(AuditType::PasswordChanged, userId);
     std::cout << "Password updated successfully.\n";
 }
 
-std::string User::toString() const {
-    std::stringstream ss;
-    ss << userId << "," << username << "," << password << "," << static_cast<int>(role);
-    return ss.str();
-}
+std::string User::toString() const { return recordToString(*this); }
 
 // --- Admin Class Method Definitions ---
 Admin::Admin(std::string uname, std::string pwd) : User(std::move(uname), std::move(pwd), Role::ADMIN) {}
@@ -350,81 +610,58 @@ RegularUser::RegularUser(std::string uname, std::string pwd) : User(std::move(un
 RegularUser::RegularUser(int id, std::string uname, std::string pwd) : User(id, std::move(uname), std::move(pwd), Role::REGULAR_USER) {}
 
 
-// --- User Factory Method Definition (User::fromString) ---
-User* User::fromString(const std::string& str) {
-    std::stringstream ss(str);
-    std::string segment;
-    int id;
-    std::string uname, pwd;
-    Role role_val;
-
-    if (str.empty() || std::count(str.begin(), str.end(), ',') < 3) {
-        std::cerr << "Warning: Malformed user data line: '" << str << "'. Skipping.\n";
-        return nullptr;
+// --- User Factory Method Definitions (User::fromFields / fromString) ---
+// The role field decides which subclass to build; the schema fills the rest.
+User* User::fromFields(const CsvFields& fields) {
+    int roleVal = -1;
+    if (fields.size() < 4 || !schema_detail::parseInt(fields[3], roleVal)) {
+        throw std::invalid_argument("bad or missing field 'role'");
+    }
+    std::unique_ptr<User> user;
+    if (roleVal == static_cast<int>(Role::ADMIN)) {
+        user.reset(new Admin());
+    } else if (roleVal == static_cast<int>(Role::REGULAR_USER)) {
+        user.reset(new RegularUser());
+    } else {
+        throw std::invalid_argument("unknown role");
     }
+    parseFields(fields, *user);
+    initNextId(user->userId);
+    return user.release();
+}
+User* User::fromString(const std::string& str) {
     try {
-        std::getline(ss, segment, ','); id = std::stoi(segment);
-        std::getline(ss, uname, ',');
-        std::getline(ss, pwd, ',');
-        std::getline(ss, segment, ','); role_val = static_cast<Role>(std::stoi(segment));
+        return fromFields(splitRecord(str));
     } catch (const std::exception& e) {
         std::cerr << "Warning: Invalid data format in user line '" << str << "': " << e.what() << ". Skipping.\n";
         return nullptr;
     }
-
-    if (role_val == Role::ADMIN) {
-        return new Admin(id, uname, pwd);
-    } else if (role_val == Role::REGULAR_USER) {
-        return new RegularUser(id, uname, pwd);
-    }
-    std::cerr << "Warning: Unknown role in user data line: '" << str << "'. Skipping.\n";
-    return nullptr;
 }
 
 // --- Attendee Class Method Definitions ---
-Attendee::Attendee(std::string n, std::string contact, int eventId)
-    : name(std::move(n)), contactInfo(std::move(contact)), eventIdRegisteredFor(eventId), isCheckedIn(false) {
-    attendeeId = nextAttendeeId++;
+Attendee::Attendee(std::string n, std::string contact, int linkedUserId)
+    : name(std::move(n)), contactInfo(std::move(contact)), userId(linkedUserId) {
+    attendeeId = nextAttendeeId;
+    nextAttendeeId = idClass.align(attendeeId + 1);
 }
-Attendee::Attendee(int id, std::string n, std::string contact, int eventId, bool checkedInStatus)
-    : attendeeId(id), name(std::move(n)), contactInfo(std::move(contact)),
-      eventIdRegisteredFor(eventId), isCheckedIn(checkedInStatus) {
+Attendee::Attendee(int id, std::string n, std::string contact, int linkedUserId)
+    : attendeeId(id), name(std::move(n)), contactInfo(std::move(contact)), userId(linkedUserId) {
     if (id >= nextAttendeeId) {
-        nextAttendeeId = id + 1;
+        nextAttendeeId = idClass.align(id + 1);
     }
 }
-void Attendee::checkIn() {
-    if (!isCheckedIn) {
-        isCheckedIn = true;
-        std::cout << name << " checked in successfully for event ID " << eventIdRegisteredFor << ".\n";
-    } else {
-        std::cout << name << " is already checked in for event ID " << eventIdRegisteredFor << ".\n";
-    }
-}
-void Attendee::displayDetails() const {
-    std::cout << "Attendee ID: " << attendeeId
-              << ", Name: " << name
-              << ", Contact: " << contactInfo
-              << ", Registered for Event ID: " << (eventIdRegisteredFor == 0 ? "N/A (Profile)" : std::to_string(eventIdRegisteredFor))
-              << ", Checked-in: " << (isCheckedIn ? "Yes" : "No") << std::endl;
-}
-std::string Attendee::toString() const {
-    std::stringstream ss;
-    ss << attendeeId << "," << name << "," << contactInfo << "," << eventIdRegisteredFor << "," << (isCheckedIn ? "1" : "0");
-    return ss.str();
-}
-Attendee Attendee::fromString(const std::string& str) {
-    std::stringstream ss(str);
-    std::string segment;
-    int id, eventId;
-    std::string name, contact;
-    bool checkedIn;
-    std::getline(ss, segment, ','); id = std::stoi(segment);
-    std::getline(ss, name, ',');
-    std::getline(ss, contact, ',');
-    std::getline(ss, segment, ','); eventId = std::stoi(segment);
-    std::getline(ss, segment, ','); checkedIn = (segment == "1");
-    return Attendee(id, name, contact, eventId, checkedIn);
+void Attendee::displayDetails(OutputBuffer& out) const {
+    out << "Attendee ID: " << attendeeId
+        << ", Name: " << name
+        << ", Contact: " << contactInfo << '\n';
+}
+std::string Attendee::toString() const { return recordToString(*this); }
+Attendee Attendee::fromString(const std::string& str) { return fromFields(splitRecord(str)); }
+Attendee Attendee::fromFields(const CsvFields& fields) {
+    Attendee attendee;
+    parseFields(fields, attendee);
+    initNextId(attendee.attendeeId);
+    return attendee;
 }
 
 // --- InventoryItem Class Method Definitions ---
@@ -466,56 +703,44 @@ void InventoryItem::setTotalQuantity(int newTotalQuantity) {
     totalQuantity = newTotalQuantity;
     std::cout << "Total quantity for '" << name << "' updated to " << totalQuantity << ".\n";
 }
-void InventoryItem::displayDetails() const {
-    std::cout << "Item ID: " << itemId << ", Name: " << name
-              << ", Total: " << totalQuantity
-              << ", Allocated: " << allocatedQuantity
-              << ", Available: " << getAvailableQuantity()
-              << ", Desc: " << description << std::endl;
-}
-std::string InventoryItem::toString() const {
-    std::stringstream ss;
-    ss << itemId << "," << name << "," << totalQuantity << "," << allocatedQuantity << "," << description;
-    return ss.str();
-}
-InventoryItem InventoryItem::fromString(const std::string& str) {
-    std::stringstream ss(str);
-    std::string segment, name, desc;
-    int id, totalQty, allocQty;
-    std::getline(ss, segment, ','); id = std::stoi(segment);
-    std::getline(ss, name, ',');
-    std::getline(ss, segment, ','); totalQty = std::stoi(segment);
-    std::getline(ss, segment, ','); allocQty = std::stoi(segment);
-    std::getline(ss, desc);
-    return InventoryItem(id, name, totalQty, allocQty, desc);
+void InventoryItem::displayDetails(OutputBuffer& out) const {
+    out << "Item ID: " << itemId << ", Name: " << name
+        << ", Total: " << totalQuantity
+        << ", Allocated: " << allocatedQuantity
+        << ", Available: " << getAvailableQuantity()
+        << ", Desc: " << description << '\n';
+}
+std::string InventoryItem::toString() const { return recordToString(*this); }
+InventoryItem InventoryItem::fromString(const std::string& str) { return fromFields(splitRecord(str)); }
+InventoryItem InventoryItem::fromFields(const CsvFields& fields) {
+    InventoryItem item;
+    parseFields(fields, item);
+    initNextId(item.itemId);
+    return item;
 }
 
 // --- Event Class Method Definitions ---
-Event::Event(std::string n, std::string d, std::string t, std::string loc, std::string desc, std::string cat)
-    : name(std::move(n)), date(std::move(d)), time(std::move(t)), location(std::move(loc)),
+Event::Event(std::string n, Date d, TimeOfDay t, std::string loc, std::string desc, std::string cat)
+    : name(std::move(n)), date(d), time(t), location(std::move(loc)),
       description(std::move(desc)), category(std::move(cat)), status(EventStatus::UPCOMING) {
-    eventId = nextEventId++;
+    eventId = nextEventId;
+    nextEventId = idClass.align(eventId + 1);
 }
-Event::Event(int id, std::string n, std::string d, std::string t, std::string loc,
+Event::Event(int id, std::string n, Date d, TimeOfDay t, std::string loc,
       std::string desc, std::string cat, EventStatus stat)
-    : eventId(id), name(std::move(n)), date(std::move(d)), time(std::move(t)), location(std::move(loc)),
+    : eventId(id), name(std::move(n)), date(d), time(t), location(std::move(loc)),
       description(std::move(desc)), category(std::move(cat)), status(stat) {
     if (id >= nextEventId) {
-        nextEventId = id + 1;
+        nextEventId = idClass.align(id + 1);
     }
 }
 void Event::addAttendee(int attId) {
-    if (std::find(attendeeIds.begin(), attendeeIds.end(), attId) == attendeeIds.end()) {
-        attendeeIds.push_back(attId);
-    } else {
+    if (!attendeeIds.insert(attId)) {
         std::cout << "Info: Attendee ID " << attId << " already registered for event '" << name << "'.\n";
     }
 }
 void Event::removeAttendee(int attId) {
-    auto it = std::find(attendeeIds.begin(), attendeeIds.end(), attId);
-    if (it != attendeeIds.end()) {
-        attendeeIds.erase(it);
-    }
+    attendeeIds.erase(attId);
 }
 void Event::allocateInventoryItem(int itmId, int quantity) {
     if (quantity > 0) allocatedInventory[itmId] += quantity;
@@ -534,7 +759,7 @@ int Event::deallocateInventoryItem(int itmId, int quantityToDeallocate) {
     }
     return 0;
 }
-std::string Event::getStatusString() const {
+const char* Event::getStatusString() const {
     switch (status) {
         case EventStatus::UPCOMING: return "Upcoming";
         case EventStatus::ONGOING: return "Ongoing";
@@ -544,76 +769,28 @@ std::string Event::getStatusString() const {
     }
 }
 std::string Event::attendeesToString() const {
-    std::stringstream ss;
-    for (size_t i = 0; i < attendeeIds.size(); ++i) {
-        ss << attendeeIds[i] << (i == attendeeIds.size() - 1 ? "" : ";");
-    }
-    return ss.str();
+    OutputBuffer out;
+    schema_detail::Codec<RoaringBitmap>::writeText(out, attendeeIds);
+    return std::string(out.view());
 }
 std::string Event::inventoryToString() const {
-    std::stringstream ss;
-    bool first = true;
-    for (auto const& [itemId, quantity] : allocatedInventory) {
-        if (!first) ss << ";";
-        ss << itemId << ":" << quantity;
-        first = false;
-    }
-    return ss.str();
-}
-std::string Event::toString() const {
-    std::stringstream ss;
-    ss << eventId << "," << name << "," << date << "," << time << "," << location << ","
-       << description << "," << category << "," << static_cast<int>(status) << ","
-       << attendeesToString() << "," << inventoryToString();
-    return ss.str();
-}
-Event Event::fromString(const std::string& str) {
-    std::stringstream ss(str);
-    std::string segment, name, date_str, time_str, loc, desc, cat, attendeesStr, inventoryStr;
-    int id;
-    EventStatus stat;
-    std::getline(ss, segment, ','); id = std::stoi(segment);
-    std::getline(ss, name, ',');
-    std::getline(ss, date_str, ',');
-    std::getline(ss, time_str, ',');
-    std::getline(ss, loc, ',');
-    std::getline(ss, desc, ',');
-    std::getline(ss, cat, ',');
-    std::getline(ss, segment, ','); stat = static_cast<EventStatus>(std::stoi(segment));
-    if (std::getline(ss, attendeesStr, ',')) {
-        std::getline(ss, inventoryStr);
-    } else {
-        inventoryStr = "";
-    }
-    Event event(id, name, date_str, time_str, loc, desc, cat, stat);
-    if (!attendeesStr.empty()) {
-        std::stringstream attSs(attendeesStr);
-        std::string attIdStr;
-        while (std::getline(attSs, attIdStr, ';')) {
-            if(!attIdStr.empty()) event.attendeeIds.push_back(std::stoi(attIdStr));
-        }
-    }
-    if (!inventoryStr.empty()) {
-        std::stringstream invSs(inventoryStr);
-        std::string itemStr;
-        while (std::getline(invSs, itemStr, ';')) {
-            if(!itemStr.empty()){
-                size_t colonPos = itemStr.find(':');
-                if (colonPos != std::string::npos) {
-                    try {
-                        event.allocatedInventory[std::stoi(itemStr.substr(0, colonPos))] = std::stoi(itemStr.substr(colonPos + 1));
-                    } catch (const std::exception& e) { /* ignore malformed */ }
-                }
-            }
-        }
-    }
+    OutputBuffer out;
+    schema_detail::Codec<std::map<int, int>>::writeText(out, allocatedInventory);
+    return std::string(out.view());
+}
+std::string Event::toString() const { return recordToString(*this); }
+Event Event::fromString(const std::string& str) { return fromFields(splitRecord(str)); }
+Event Event::fromFields(const CsvFields& fields) {
+    Event event;
+    parseFields(fields, event);
+    initNextId(event.eventId);
     return event;
 }
 
 
 // --- System Method Definitions ---
 System::~System() {
-    saveData();
+    if (!replica) saveData();
     for (User* u : users) delete u;
     users.clear();
 }
@@ -622,19 +799,19 @@ void System::seedInitialData() {
     bool dataSeeded = false;
     if (users.empty()) {
         std::cout << "Info: No users found. Seeding initial accounts.\n";
-        users.push_back(new Admin("admin", "adminpass"));
+        addUser(new Admin("admin", "adminpass"));
         std::cout << "Seeded Admin: admin (ID: " << users.back()->getUserId() << ")\n";
-        users.push_back(new RegularUser("user1", "user1pass"));
+        addUser(new RegularUser("user1", "user1pass"));
         std::cout << "Seeded User: user1 (ID: " << users.back()->getUserId() << ")\n";
-        users.push_back(new RegularUser("user2", "user2pass"));
+        addUser(new RegularUser("user2", "user2pass"));
         std::cout << "Seeded User: user2 (ID: " << users.back()->getUserId() << ")\n";
         dataSeeded = true;
     }
     if (events.empty()) {
         std::cout << "Info: No events found. Seeding initial events.\n";
-        events.emplace_back("Tech Conference 2025", "2025-10-20", "09:00", "Grand Hall", "Annual tech conference", "Conference");
+        events.emplace_back("Tech Conference 2025", dateLiteral("2025-10-20"), timeLiteral("09:00"), "Grand Hall", "Annual tech conference", "Conference");
         std::cout << "Seeded Event: Tech Conference 2025 (ID: " << events.back().eventId << ")\n";
-        events.emplace_back("Summer Music Festival", "2025-07-15", "14:00", "City Park", "Outdoor music event", "Social");
+        events.emplace_back("Summer Music Festival", dateLiteral("2025-07-15"), timeLiteral("14:00"), "City Park", "Outdoor music event", "Social");
         std::cout << "Seeded Event: Summer Music Festival (ID: " << events.back().eventId << ")\n";
         dataSeeded = true;
     }
@@ -653,66 +830,172 @@ void System::seedInitialData() {
 }
 
 void System::loadData() {
-    loadUsers(); loadEvents(); loadInventory(); loadAttendees();
+    LatencyScope timer(latency_op::load);
+    TraceSpan span("loadData", "load");
+    SlowOp slow("loadData");
+    loadUsers(); slow.phase("loadUsers");
+    loadEvents(); slow.phase("loadEvents");
+    loadInventory(); slow.phase("loadInventory");
+    loadAttendees(); slow.phase("loadAttendees");
+    loadRegistrations(); slow.phase("loadRegistrations");
+    slow.count("users", users.size());
+    slow.count("events", events.size());
+    slow.count("registrations", registrations.size());
     int maxId = 0; for(const auto* u : users) if(u && u->getUserId() > maxId) maxId = u->getUserId(); User::initNextId(maxId +1);
     maxId = 0; for(const auto& e : events) if(e.eventId > maxId) maxId = e.eventId; Event::initNextId(maxId+1);
     maxId = 0; for(const auto& i : inventory) if(i.itemId > maxId) maxId = i.itemId; InventoryItem::initNextId(maxId+1);
     maxId = 0; for(const auto& a : allAttendees) if(a.attendeeId > maxId) maxId = a.attendeeId; Attendee::initNextId(maxId+1);
 }
-void System::saveData() { saveUsers(); saveEvents(); saveInventory(); saveAttendees(); }
+void System::clearData() {
+    currentUser = nullptr;
+    AuditLog::setActor(0);
+    for (User* u : users) delete u;
+    users.clear(); userIndex.clear();
+    events.clear(); inventory.clear();
+    allAttendees.clear(); attendeeIndex.clear(); attendeeByUser.clear();
+    registrations.clear(); registrationIndex.clear(); eventsByAttendee.clear();
+}
+void System::saveData() {
+    TraceSpan span("saveData", "save");
+    SlowOp slow("saveData");
+    saveUsers(); slow.phase("saveUsers");
+    saveEvents(); slow.phase("saveEvents");
+    saveInventory(); slow.phase("saveInventory");
+    saveAttendees(); slow.phase("saveAttendees");
+    saveRegistrations(); slow.phase("saveRegistrations");
+}
 
+void System::writeDataFile(const std::string& path) {
+    if (writeBehind) { writeBehind->submit(path, std::string(fileBuffer.view())); return; }
+    if (!fileBuffer.writeFile(path)) { std::cerr << "Err: " << path << " write.\n"; }
+}
 void System::loadUsers() {
-    std::ifstream inFile(USERS_FILE); if (!inFile) return;
-    std::string line; while (std::getline(inFile, line)) if (!line.empty()) { User* u = User::fromString(line); if(u) users.push_back(u); }
-    inFile.close();
+    TraceSpan span("loadUsers", "load");
+    forEachRecordInFile(usersPath, [this](const CsvFields& f) { addUser(User::fromFields(f)); });
 }
 void System::saveUsers() {
-    std::ofstream outFile(USERS_FILE); if (!outFile) { std::cerr << "Err: USERS_FILE write.\n"; return; }
-    for (const auto* user : users) if (user) outFile << user->toString() << std::endl;
-    outFile.close();
+    LatencyScope timer(latency_op::saveUsers);
+    TraceSpan span("saveUsers", "save");
+    fileBuffer.clear();
+    for (const auto* user : users) if (user) { appendText(fileBuffer, *user); fileBuffer << '\n'; }
+    writeDataFile(usersPath);
 }
 void System::loadEvents() {
-    std::ifstream inFile(EVENTS_FILE); if (!inFile) return;
-    std::string line; while (std::getline(inFile, line)) if (!line.empty()) events.push_back(Event::fromString(line));
-    inFile.close();
+    TraceSpan span("loadEvents", "load");
+    forEachRecordInFile(eventsPath, [this](const CsvFields& f) { events.push_back(Event::fromFields(f)); });
 }
 void System::saveEvents() {
-    std::ofstream outFile(EVENTS_FILE); if (!outFile) { std::cerr << "Err: EVENTS_FILE write.\n"; return; }
-    for (const auto& event : events) outFile << event.toString() << std::endl;
-    outFile.close();
+    LatencyScope timer(latency_op::saveEvents);
+    TraceSpan span("saveEvents", "save");
+    fileBuffer.clear();
+    for (const auto& event : events) { appendText(fileBuffer, event); fileBuffer << '\n'; }
+    writeDataFile(eventsPath);
 }
 void System::loadInventory() {
-    std::ifstream inFile(INVENTORY_FILE); if (!inFile) return;
-    std::string line; while (std::getline(inFile, line)) if (!line.empty()) inventory.push_back(InventoryItem::fromString(line));
-    inFile.close();
+    TraceSpan span("loadInventory", "load");
+    forEachRecordInFile(inventoryPath, [this](const CsvFields& f) { inventory.push_back(InventoryItem::fromFields(f)); });
 }
 void System::saveInventory() {
-    std::ofstream outFile(INVENTORY_FILE); if (!outFile) { std::cerr << "Err: INVENTORY_FILE write.\n"; return; }
-    for (const auto& item : inventory) outFile << item.toString() << std::endl;
-    outFile.close();
+    LatencyScope timer(latency_op::saveInventory);
+    TraceSpan span("saveInventory", "save");
+    fileBuffer.clear();
+    for (const auto& item : inventory) { appendText(fileBuffer, item); fileBuffer << '\n'; }
+    writeDataFile(inventoryPath);
 }
+// Older attendees.txt records (id,name,contact,eventId,checkedIn) held one
+// registration each; they load as a profile plus that registration.
+// Legacy files have one (id,name,contact,eventId,checkedIn) row per
+// registration; rows with the same name and contact become one profile
+// holding all of their registrations, and the events' attendee lists are
+// pointed at that profile.
 void System::loadAttendees() {
-    std::ifstream inFile(ATTENDEES_FILE); if (!inFile) return;
-    std::string line; while (std::getline(inFile, line)) if (!line.empty()) allAttendees.push_back(Attendee::fromString(line));
-    inFile.close();
+    TraceSpan span("loadAttendees", "load");
+    std::unordered_map<std::string, int> legacyProfiles; // name '\0' contact -> attendeeId
+    std::unordered_map<int, int> mergedInto;             // legacy attendeeId -> profile that absorbed it
+    forEachRecordInFile(attendeesPath, [&](const CsvFields& f) {
+        if (f.size() != 5) { addAttendee(Attendee::fromFields(f)); return; }
+        CsvFields profile{f[0], f[1], f[2], "0"}; // Not linked to an account
+        int eventId; bool checkedIn;
+        if (!schema_detail::parseInt(f[3], eventId) || !schema_detail::Codec<bool>::readText(f[4], checkedIn))
+            throw std::invalid_argument("bad legacy registration");
+        Attendee row = Attendee::fromFields(profile);
+        auto [known, fresh] = legacyProfiles.try_emplace(row.name + '\0' + row.contactInfo, row.attendeeId);
+        int attendeeId = known->second;
+        if (fresh) addAttendee(std::move(row));
+        else if (row.attendeeId != attendeeId) mergedInto.emplace(row.attendeeId, attendeeId);
+        if (eventId == 0) return;
+        uint8_t flags = checkedIn ? Registration::CHECKED_IN : 0;
+        if (Registration* existing = findRegistration(attendeeId, eventId)) existing->flags |= flags;
+        else addRegistration(attendeeId, eventId, flags);
+    });
+    if (mergedInto.empty()) return;
+    for (auto& event : events) {
+        std::vector<int> merged;
+        event.attendeeIds.forEach([&](int attendeeId) { if (mergedInto.count(attendeeId)) merged.push_back(attendeeId); });
+        for (int attendeeId : merged) {
+            event.attendeeIds.erase(attendeeId);
+            int profileId = mergedInto[attendeeId];
+            if (!findRegistration(profileId, event.eventId)) addRegistration(profileId, event.eventId);
+        }
+    }
 }
 void System::saveAttendees() {
-    std::ofstream outFile(ATTENDEES_FILE); if (!outFile) { std::cerr << "Err: ATTENDEES_FILE write.\n"; return; }
-    for (const auto& attendee : allAttendees) outFile << attendee.toString() << std::endl;
-    outFile.close();
+    LatencyScope timer(latency_op::saveAttendees);
+    TraceSpan span("saveAttendees", "save");
+    fileBuffer.clear();
+    for (const auto& attendee : allAttendees) { appendText(fileBuffer, attendee); fileBuffer << '\n'; }
+    writeDataFile(attendeesPath);
 }
-bool System::usernameExists(const std::string& uname) const {
-    for (const auto* user : users) if (user && user->getUsername() == uname) return true;
-    return false;
+// Registrations also come from the attendee lists in events.txt; the two are
+// merged so each index covers both.
+void System::loadRegistrations() {
+    TraceSpan span("loadRegistrations", "load");
+    forEachRecordInFile(registrationsPath, [this](const CsvFields& f) {
+        Registration r;
+        parseFields(f, r);
+        if (Registration* existing = findRegistration(r.attendeeId, r.eventId)) existing->flags |= r.flags;
+        else if (!addRegistration(r.attendeeId, r.eventId, r.flags)) throw std::invalid_argument("unknown attendee or event");
+    });
+    for (auto& event : events) {
+        std::vector<int> orphans;
+        event.attendeeIds.forEach([&](int attendeeId) {
+            if (!findRegistration(attendeeId, event.eventId) && !addRegistration(attendeeId, event.eventId)) orphans.push_back(attendeeId);
+        });
+        for (int attendeeId : orphans) {
+            std::cerr << "Warning: Dropping unknown attendee " << attendeeId << " from event " << event.eventId << ".\n";
+            event.attendeeIds.erase(attendeeId);
+        }
+    }
+}
+void System::saveRegistrations() {
+    LatencyScope timer(latency_op::saveRegistrations);
+    TraceSpan span("saveRegistrations", "save");
+    fileBuffer.clear();
+    for (const auto& registration : registrations) { appendText(fileBuffer, registration); fileBuffer << '\n'; }
+    writeDataFile(registrationsPath);
 }
-void System::createUserAccount(const std::string& uname, const std::string& pwd, Role role) {
-    if (usernameExists(uname)) { std::cout << "Username already exists.\n"; return;}
-    if (pwd.length() < 6) { std::cout << "Password too short.\n"; return; }
-    if (role == Role::ADMIN) users.push_back(new Admin(uname, pwd));
-    else if (role == Role::REGULAR_USER) users.push_back(new RegularUser(uname, pwd));
-    else { std::cout << "Invalid role.\n"; return; }
+void System::addUser(User* user) {
+    TraceSpan span("addUser", "index");
+    users.push_back(user);
+    userIndex.emplace(user->getUsername(), user); // First account with a name wins, as in a linear scan
+    journalRecord("user", *user);
+}
+bool System::usernameExists(std::string_view uname) const { return userIndex.count(uname) != 0; }
+bool System::createUserAccount(const std::string& uname, const std::string& pwd, Role role) {
+    LatencyScope timer(latency_op::registerUser);
+    SlowOp slow("createUserAccount");
+    slow.text("user", uname);
+    if (usernameExists(uname)) { std::cout << "Username already exists.\n"; return false; }
+    if (pwd.length() < 6) { std::cout << "Password too short.\n"; return false; }
+    if (role == Role::ADMIN) addUser(new Admin(uname, pwd));
+    else if (role == Role::REGULAR_USER) addUser(new RegularUser(uname, pwd));
+    else { std::cout << "Invalid role.\n"; return false; }
     std::cout << (role == Role::ADMIN ? "Admin" : "User") << " '" << uname << "' created (ID: " << users.back()->getUserId() << ").\n";
-    saveUsers();
+    AuditLog::record(AuditType::UserCreated, users.back()->getUserId(), role == Role::ADMIN, 0, uname);
+    slow.phase("insert");
+    slow.count("users", users.size());
+    if (autoSave) { saveUsers(); slow.phase("saveUsers"); }
+    return true;
 }
 void System::publicRegisterNewUser() {
     std::cout << "\n--- Register New User ---\n";
@@ -724,69 +1007,301 @@ void System::publicRegisterNewUser() {
     if (rChoice != 1 && rChoice != 2) newRole = Role::NONE; // Mark as invalid if choice is bad
     createUserAccount(uname, pwd, newRole);
 }
-void System::deleteUserAccount(const std::string& uname) {
+bool System::deleteUserAccount(std::string_view uname) {
+    SlowOp slow("deleteUserAccount");
+    slow.text("user", uname);
+    slow.count("users", users.size());
+    bool self = false;
     auto it = std::remove_if(users.begin(), users.end(), [&](User* u) {
         if (u && u->getUsername() == uname) {
-            if (currentUser && currentUser->getUsername() == uname) { std::cout << "Cannot delete self.\n"; return false; }
+            if (currentUser && currentUser->getUsername() == uname) { std::cout << "Cannot delete self.\n"; self = true; return false; }
+            auto indexed = userIndex.find(uname);
+            if (indexed != userIndex.end() && indexed->second == u) userIndex.erase(indexed);
+            AuditLog::record(AuditType::UserDeleted, u->getUserId(), 0, 0, uname);
+            journalKey("user-", u->getUserId());
             delete u; return true;
         }
         return false;
     });
-    if (it != users.end()) { users.erase(it, users.end()); std::cout << "User '" << uname << "' deleted.\n"; saveUsers(); }
-    else { std::cout << "User '" << uname << "' not found.\n"; }
+    slow.phase("remove");
+    if (it != users.end()) {
+        users.erase(it, users.end());
+        std::cout << "User '" << uname << "' deleted.\n";
+        if (autoSave) { saveUsers(); slow.phase("saveUsers"); }
+        return true;
+    }
+    if (!self) std::cout << "User '" << uname << "' not found.\n";
+    return false;
 }
-User* System::findUserByUsername(const std::string& uname) {
-    for (auto* user : users) if (user && user->getUsername() == uname) return user; return nullptr;
+User* System::findUserByUsername(std::string_view uname) {
+    auto it = userIndex.find(uname); return it == userIndex.end() ? nullptr : it->second;
 }
-const User* System::findUserByUsername(const std::string& uname) const {
-    for (const auto* user : users) if (user && user->getUsername() == uname) return user; return nullptr;
+const User* System::findUserByUsername(std::string_view uname) const {
+    auto it = userIndex.find(uname); return it == userIndex.end() ? nullptr : it->second;
 }
 void System::listAllUsers() const {
-    std::cout << "\n--- All Users ---\n"; if (users.empty()) { std::cout << "No users.\n"; return; }
-    for (const auto* user : users) if (user) std::cout << "ID: " << user->getUserId() << ", User: " << user->getUsername() << ", Role: " << (user->getRole() == Role::ADMIN ? "Admin" : "User") << std::endl;
+    TraceSpan span("listAllUsers", "report");
+    pageBuffer << "\n--- All Users ---\n";
+    if (users.empty()) pageBuffer << "No users.\n";
+    for (const auto* user : users) if (user) pageBuffer << "ID: " << user->getUserId() << ", User: " << user->getUsername() << ", Role: " << (user->getRole() == Role::ADMIN ? "Admin" : "User") << '\n';
+    pageBuffer.flushTo(std::cout);
 }
 bool System::login() {
     std::cout << "\n--- Login ---\n";
-    std::string uname = getStringInput("Username: "); std::string pwd = getStringInput("Password: ");
-    for (User* u : users) if (u && u->getUsername() == uname && u->getPassword() == pwd) {
-        currentUser = u; std::cout << "Login successful. Welcome, " << currentUser->getUsername() << "!\n"; return true;
+    std::pmr::string uname = getStringInput("Username: ", scratch); std::pmr::string pwd = getStringInput("Password: ", scratch);
+    return login(uname, pwd);
+}
+bool System::login(std::string_view uname, std::string_view pwd) {
+    LatencyScope timer(latency_op::login);
+    User* u = findUserByUsername(uname);
+    if (u && u->getPassword() == pwd) {
+        currentUser = u; AuditLog::setActor(u->getUserId());
+        std::cout << "Login successful. Welcome, " << currentUser->getUsername() << "!\n"; return true;
     }
-    std::cout << "Login failed.\n"; currentUser = nullptr; return false;
+    std::cout << "Login failed.\n"; currentUser = nullptr; AuditLog::setActor(0); return false;
+}
+void System::logout() {
+    if (currentUser) { std::cout << "Logging out " << currentUser->getUsername() << ".\n"; currentUser = nullptr; AuditLog::setActor(0); }
 }
-void System::logout() { if (currentUser) { std::cout << "Logging out " << currentUser->getUsername() << ".\n"; currentUser = nullptr; } }
 
 Event* System::findEventById(int eventId) { for (auto& event : events) if (event.eventId == eventId) return &event; return nullptr; }
 const Event* System::findEventById(int eventId) const { for (const auto& event : events) if (event.eventId == eventId) return &event; return nullptr; }
 
 void System::createEvent() {
     std::cout << "\n--- Create Event ---\n";
-    std::string name = getStringInput("Name: "); std::string date, time;
-    while(true){ date = getStringInput("Date (YYYY-MM-DD): "); if(isValidDate(date)) break; std::cout << "Invalid date.\n"; }
-    while(true){ time = getStringInput("Time (HH:MM): "); if(isValidTime(time)) break; std::cout << "Invalid time.\n"; }
+    std::string name = getStringInput("Name: "); std::pmr::string date(scratch.resource()), time(scratch.resource());
+    Date parsedDate; TimeOfDay parsedTime;
+    while(true){ readNonEmptyLine("Date (YYYY-MM-DD): ", date); if(parseDate(date, parsedDate)) break; std::cout << "Invalid date.\n"; }
+    while(true){ readNonEmptyLine("Time (HH:MM): ", time); if(parseTime(time, parsedTime)) break; std::cout << "Invalid time.\n"; }
     std::string loc = getStringInput("Location: "); std::string desc = getStringInput("Description: "); std::string cat = getStringInput("Category: ");
-    events.emplace_back(name, date, time, loc, desc, cat);
-    std::cout << "Event '" << name << "' created (ID: " << events.back().eventId << ").\n"; saveEvents();
+    createEvent(name, date, time, loc, desc, cat);
+}
+bool System::createEvent(std::string_view name, std::string_view date, std::string_view time,
+                         std::string_view loc, std::string_view desc, std::string_view cat) {
+    Date parsedDate; TimeOfDay parsedTime;
+    if (!parseDate(date, parsedDate)) { std::cout << "Invalid date.\n"; return false; }
+    if (!parseTime(time, parsedTime)) { std::cout << "Invalid time.\n"; return false; }
+    events.emplace_back(std::string(name), parsedDate, parsedTime, std::string(loc), std::string(desc), std::string(cat));
+    std::cout << "Event '" << name << "' created (ID: " << events.back().eventId << ").\n";
+    AuditLog::record(AuditType::EventCreated, events.back().eventId, 0, 0, name);
+    journalRecord("event", events.back());
+    if (autoSave) saveEvents();
+    return true;
 }
 void System::viewAllEvents(bool adminView) const {
-    std::cout << "\n--- All Events ---\n"; if (events.empty()) { std::cout << "No events.\n"; return; }
-    for (const auto& event : events) { event.displayDetails(*this); std::cout << "-------------------\n"; }
+    TraceSpan span("viewAllEvents", "report");
+    pageBuffer << "\n--- All Events ---\n"; if (events.empty()) pageBuffer << "No events.\n";
+    for (const auto& event : events) { event.displayDetails(*this, pageBuffer); pageBuffer << "-------------------\n"; }
+    pageBuffer.flushTo(std::cout);
+}
+void System::searchEventsByNameOrDate() const {
+    std::cout << "\n--- Search Events ---\n";
+    std::pmr::string input = getStringInput("Name keyword, date, or date range (FROM TO): ", scratch);
+    std::string_view term = input;
+    Date from, to;
+    size_t space = term.find(' ');
+    if (parseDate(term, from)) showEventList(findEventsBetween(from, from));
+    else if (space != std::string_view::npos && parseDate(term.substr(0, space), from) && parseDate(term.substr(space + 1), to))
+        showEventList(findEventsBetween(from, to));
+    else showEventList(findEventsByName(term));
+}
+// Events dated within [from, to], in chronological order
+std::pmr::vector<const Event*> System::findEventsBetween(Date from, Date to) const {
+    LatencyScope timer(latency_op::searchDates);
+    TraceSpan span("findEventsBetween", "query");
+    std::pmr::vector<const Event*> found(scratch.resource());
+    for (const auto& event : events) if (from <= event.date && event.date <= to) found.push_back(&event);
+    std::sort(found.begin(), found.end(), [](const Event* a, const Event* b) {
+        return dateTimeKey(a->date, a->time) < dateTimeKey(b->date, b->time);
+    });
+    return found;
+}
+// Case-insensitive name match, in chronological order
+std::pmr::vector<const Event*> System::findEventsByName(std::string_view keyword) const {
+    LatencyScope timer(latency_op::searchName);
+    TraceSpan span("findEventsByName", "query");
+    std::pmr::vector<const Event*> found(scratch.resource());
+    for (const auto& event : events) if (containsIgnoreCase(event.name, keyword)) found.push_back(&event);
+    std::sort(found.begin(), found.end(), [](const Event* a, const Event* b) {
+        return dateTimeKey(a->date, a->time) < dateTimeKey(b->date, b->time);
+    });
+    return found;
+}
+void System::showEventList(const std::pmr::vector<const Event*>& found) const {
+    TraceSpan span("showEventList", "report");
+    pageBuffer << "Found " << found.size() << " event(s).\n";
+    for (const Event* event : found) { event->displayDetails(*this, pageBuffer); pageBuffer << "-------------------\n"; }
+    pageBuffer.flushTo(std::cout);
 }
-void System::searchEventsByNameOrDate() const { /* Simplified, implement as needed */ std::cout << "Search not fully implemented.\n"; }
 void System::editEventDetails() { /* Simplified */ std::cout << "Edit Event not fully implemented.\n"; }
 void System::deleteEvent() { /* Simplified */ std::cout << "Delete Event not fully implemented.\n"; }
 void System::updateEventStatus() { /* Simplified */ std::cout << "Update Status not fully implemented.\n"; }
-Attendee* System::findAttendeeInMasterList(int attendeeId) { for(auto& att : allAttendees) if(att.attendeeId == attendeeId) return &att; return nullptr; }
-const Attendee* System::findAttendeeInMasterList(int attendeeId) const { for(const auto& att : allAttendees) if(att.attendeeId == attendeeId) return &att; return nullptr; }
-void System::registerAttendeeForEvent() { /* Simplified */ std::cout << "Register Attendee not fully implemented.\n"; }
-void System::cancelOwnRegistration() { /* Simplified */ std::cout << "Cancel Registration not fully implemented.\n"; }
+Attendee* System::findAttendeeInMasterList(int attendeeId) {
+    auto it = attendeeIndex.find(attendeeId); return it == attendeeIndex.end() ? nullptr : &allAttendees[it->second];
+}
+const Attendee* System::findAttendeeInMasterList(int attendeeId) const {
+    auto it = attendeeIndex.find(attendeeId); return it == attendeeIndex.end() ? nullptr : &allAttendees[it->second];
+}
+Attendee& System::addAttendee(Attendee attendee) {
+    TraceSpan span("addAttendee", "index");
+    if (attendeeIndex.count(attendee.attendeeId)) throw std::invalid_argument("duplicate attendee ID " + std::to_string(attendee.attendeeId));
+    attendeeIndex.emplace(attendee.attendeeId, allAttendees.size());
+    if (attendee.userId != 0) attendeeByUser.emplace(attendee.userId, attendee.attendeeId);
+    allAttendees.push_back(std::move(attendee));
+    journalRecord("attendee", allAttendees.back());
+    return allAttendees.back();
+}
+Attendee& System::profileForUser(const User& user) {
+    auto it = attendeeByUser.find(user.getUserId());
+    if (it != attendeeByUser.end()) return *findAttendeeInMasterList(it->second);
+    return addAttendee(Attendee(user.getUsername(), "", user.getUserId()));
+}
+Registration* System::findRegistration(int attendeeId, int eventId) {
+    auto it = registrationIndex.find(Registration::key(attendeeId, eventId));
+    return it == registrationIndex.end() ? nullptr : &registrations[it->second];
+}
+// False if the attendee or event does not exist or the registration already does
+bool System::addRegistration(int attendeeId, int eventId, uint8_t flags) {
+    TraceSpan span("addRegistration", "index");
+    Event* event = findEventById(eventId);
+    if (!event || !findAttendeeInMasterList(attendeeId)) return false;
+    if (!registrationIndex.emplace(Registration::key(attendeeId, eventId), registrations.size()).second) return false;
+    registrations.push_back({attendeeId, eventId, flags});
+    journalRecord("reg", registrations.back());
+    event->attendeeIds.insert(attendeeId);
+    eventsByAttendee[attendeeId].insert(eventId);
+    return true;
+}
+bool System::removeRegistration(int attendeeId, int eventId) {
+    TraceSpan span("removeRegistration", "index");
+    auto it = registrationIndex.find(Registration::key(attendeeId, eventId));
+    if (it == registrationIndex.end()) return false;
+    size_t slot = it->second;
+    registrationIndex.erase(it);
+    if (slot != registrations.size() - 1) { // Move the last row into the gap
+        registrations[slot] = registrations.back();
+        registrationIndex[Registration::key(registrations[slot].attendeeId, registrations[slot].eventId)] = slot;
+    }
+    registrations.pop_back();
+    if (Event* event = findEventById(eventId)) event->attendeeIds.erase(attendeeId);
+    eventsByAttendee[attendeeId].erase(eventId);
+    journalKey("reg-", attendeeId, eventId);
+    return true;
+}
+bool System::checkIn(int attendeeId, int eventId) {
+    LatencyScope timer(latency_op::checkIn);
+    TraceSpan span("checkIn", "registration");
+    SlowOp slow("checkIn");
+    slow.count("attendeeId", attendeeId);
+    slow.count("eventId", eventId);
+    Registration* r = findRegistration(attendeeId, eventId);
+    if (!r) return false;
+    r->flags |= Registration::CHECKED_IN;
+    AuditLog::record(AuditType::CheckedIn, eventId, attendeeId);
+    journalRecord("reg", *r);
+    return true;
+}
+// The profile is the only copy of a person's contact details
+void System::updateContactInfo(int attendeeId, std::string_view contact) {
+    Attendee* attendee = findAttendeeInMasterList(attendeeId);
+    if (!attendee) throw std::invalid_argument("no attendee with ID " + std::to_string(attendeeId));
+    SlowOp slow("updateContactInfo");
+    slow.count("attendeeId", attendeeId);
+    slow.count("attendees", allAttendees.size());
+    attendee->contactInfo.assign(contact.data(), contact.size());
+    AuditLog::record(AuditType::ContactUpdated, attendeeId);
+    journalRecord("attendee", *attendee);
+    slow.phase("update");
+    if (autoSave) { saveAttendees(); slow.phase("saveAttendees"); }
+}
+RoaringBitmap System::attendeesOfEvent(int eventId) const {
+    const Event* event = findEventById(eventId);
+    if (!event) throw std::invalid_argument("no event with ID " + std::to_string(eventId));
+    return event->attendeeIds;
+}
+// Anyone registered for at least one event in the category (case-insensitive)
+RoaringBitmap System::attendeesOfCategory(std::string_view category) const {
+    RoaringBitmap audience;
+    for (const auto& event : events) if (equalsIgnoreCase(event.category, category)) audience |= event.attendeeIds;
+    return audience;
+}
+// Evaluates "<term> [and|or|minus <term>]..." left to right, where a term is
+// an event ID or category:<name>. E.g. "12 and 15" (attended both),
+// "category:Workshop minus 12".
+RoaringBitmap System::evaluateAudience(const CommandLine& cmd, size_t first) const {
+    TraceSpan span("evaluateAudience", "query");
+    auto term = [&](size_t i) {
+        std::string_view t = cmd[i];
+        if (t.substr(0, 9) == "category:") return attendeesOfCategory(t.substr(9));
+        int eventId;
+        if (!cmd.getInt(i, eventId)) throw std::invalid_argument("expected an event ID or category:<name>");
+        return attendeesOfEvent(eventId);
+    };
+    if (first >= cmd.size()) throw std::invalid_argument("empty audience query");
+    RoaringBitmap audience = term(first);
+    for (size_t i = first + 1; i < cmd.size(); i += 2) {
+        if (i + 1 >= cmd.size()) throw std::invalid_argument("missing term after " + std::string(cmd[i]));
+        std::string_view op = cmd[i];
+        if (op == "and") audience &= term(i + 1);
+        else if (op == "or") audience |= term(i + 1);
+        else if (op == "minus") audience -= term(i + 1);
+        else throw std::invalid_argument("expected and/or/minus, got " + std::string(op));
+    }
+    return audience;
+}
+void System::showAudience(const RoaringBitmap& audience) const {
+    TraceSpan span("showAudience", "report");
+    pageBuffer << "Audience: " << audience.size() << " attendee(s).\n";
+    for (const auto& att : allAttendees)
+        if (audience.contains(att.attendeeId)) pageBuffer << "  ID: " << att.attendeeId << ", Name: " << att.name << '\n';
+    pageBuffer.flushTo(std::cout);
+}
+void System::registerAttendeeForEvent() {
+    if (!currentUser) { std::cout << "Login required.\n"; return; }
+    int eventId = getPositiveIntInput("Event ID to register for: ");
+    LatencyScope timer(latency_op::registerEvent);
+    TraceSpan span("registerAttendeeForEvent", "registration");
+    SlowOp slow("registerAttendeeForEvent");
+    slow.count("eventId", eventId);
+    if (!findEventById(eventId)) { std::cout << "Event not found.\n"; return; }
+    int attendeeId = profileForUser(*currentUser).attendeeId;
+    if (!addRegistration(attendeeId, eventId)) { std::cout << "Already registered.\n"; return; }
+    AuditLog::record(AuditType::Registered, eventId, attendeeId);
+    std::cout << "Registered for event " << eventId << ".\n";
+    slow.phase("register");
+    slow.count("registrations", registrations.size());
+    if (autoSave) {
+        saveAttendees(); slow.phase("saveAttendees");
+        saveEvents(); slow.phase("saveEvents");
+        saveRegistrations(); slow.phase("saveRegistrations");
+    }
+}
+void System::cancelOwnRegistration() {
+    if (!currentUser) { std::cout << "Login required.\n"; return; }
+    int eventId = getPositiveIntInput("Event ID to cancel: ");
+    LatencyScope timer(latency_op::cancelRegistration);
+    TraceSpan span("cancelOwnRegistration", "registration");
+    SlowOp slow("cancelOwnRegistration");
+    slow.count("eventId", eventId);
+    int attendeeId = profileForUser(*currentUser).attendeeId;
+    if (!removeRegistration(attendeeId, eventId)) { std::cout << "Not registered for that event.\n"; return; }
+    AuditLog::record(AuditType::Unregistered, eventId, attendeeId);
+    std::cout << "Registration cancelled.\n";
+    slow.phase("unregister");
+    slow.count("registrations", registrations.size());
+    if (autoSave) {
+        saveEvents(); slow.phase("saveEvents");
+        saveRegistrations(); slow.phase("saveRegistrations");
+    }
+}
 void System::viewAttendeeListsPerEvent() const { /* Simplified */ std::cout << "View Attendee Lists not fully implemented.\n"; }
 void System::checkInAttendeeForEvent() { /* Simplified */ std::cout << "Check-in not fully implemented.\n"; }
 void System::generateAttendanceReportForEvent() const { /* Simplified */ std::cout << "Attendance Report not fully implemented.\n"; }
 void System::exportAttendeeListForEventToFile() const { /* Simplified */ std::cout << "Export List not fully implemented.\n"; }
 InventoryItem* System::findInventoryItemById(int itemId) { for(auto& item : inventory) if(item.itemId == itemId) return &item; return nullptr; }
 const InventoryItem* System::findInventoryItemById(int itemId) const { for(const auto& item : inventory) if(item.itemId == itemId) return &item; return nullptr; }
-InventoryItem* System::findInventoryItemByName(const std::string& name) { std::string ln = toLower(name); for(auto& item : inventory) if(toLower(item.name)==ln) return &item; return nullptr; }
-const InventoryItem* System::findInventoryItemByName(const std::string& name) const { std::string ln = toLower(name); for(const auto& item : inventory) if(toLower(item.name)==ln) return &item; return nullptr; }
+InventoryItem* System::findInventoryItemByName(std::string_view name) { for(auto& item : inventory) if(equalsIgnoreCase(item.name, name)) return &item; return nullptr; }
+const InventoryItem* System::findInventoryItemByName(std::string_view name) const { for(const auto& item : inventory) if(equalsIgnoreCase(item.name, name)) return &item; return nullptr; }
 void System::addInventoryItem() { /* Simplified */ std::cout << "Add Inventory not fully implemented.\n"; }
 void System::updateInventoryItemDetails() { /* Simplified */ std::cout << "Update Inventory not fully implemented.\n"; }
 void System::viewAllInventoryItems() const { /* Simplified */ std::cout << "View All Inventory not fully implemented.\n"; }
@@ -795,7 +1310,13 @@ void System::generateFullInventoryReport() const { /* Simplified */ std::cout <<
 void System::exportAllEventsDataToFile() const { /* Simplified */ std::cout << "Export Events not fully implemented.\n"; }
 void System::exportAllAttendeesDataToFile() const { /* Simplified */ std::cout << "Export Attendees not fully implemented.\n"; }
 void System::exportAllInventoryDataToFile() const { /* Simplified */ std::cout << "Export Inventory not fully implemented.\n"; }
-void System::updateCurrentLoggedInUserContactInfo() { /* Simplified */ std::cout << "Update Contact Info not fully implemented.\n"; }
+void System::updateCurrentLoggedInUserContactInfo() {
+    if (!currentUser) { std::cout << "Login required.\n"; return; }
+    Attendee& profile = profileForUser(*currentUser);
+    std::cout << "Current contact: " << (profile.contactInfo.empty() ? "(none)" : profile.contactInfo) << "\n";
+    updateContactInfo(profile.attendeeId, getStringInput("New contact info: ", scratch));
+    std::cout << "Contact info updated.\n";
+}
 
 
 // --- Admin::displayMenu Definition ---
@@ -805,6 +1326,7 @@ void Admin::displayMenu(System& sys) {
         std::cout << "\n--- Admin Menu (" << username << ") ---\n";
         std::cout << "1. User Accounts\n2. Events\n3. Attendees (Admin)\n4. Inventory\n5. Data Export\n6. Logout\n";
         choice = getIntInput("Choice (1-6): ");
+        ScratchArena::Scope request(sys.scratch);
         switch (choice) {
             case 1: adminUserManagementMenu(sys); break;
             case 2: adminEventManagementMenu(sys); break;
@@ -814,17 +1336,19 @@ void Admin::displayMenu(System& sys) {
             case 6: sys.logout(); return;
             default: std::cout << "Invalid choice.\n";
         }
+        sys.afterRequest();
     }
 }
 void Admin::adminUserManagementMenu(System& sys) {
     int choice;
     std::cout << "\n  -- User Account Mgmt --\n  1. Create User\n  2. Delete User\n  3. List Users\n  4. Back\n";
     choice = getIntInput("  Choice (1-4): "); std::string uname, pwd; int rChoice;
+    ScratchArena::Scope request(sys.scratch);
     switch(choice) {
         case 1: uname = getStringInput("New Username: "); pwd = getStringInput("Password: ");
                 std::cout << "Role: 1.Admin 2.Regular User\n"; rChoice = getIntInput("Role (1-2): ");
                 sys.createUserAccount(uname, pwd, (rChoice==1 ? Role::ADMIN : Role::REGULAR_USER)); break;
-        case 2: uname = getStringInput("Username to delete: "); sys.deleteUserAccount(uname); break;
+        case 2: sys.deleteUserAccount(getStringInput("Username to delete: ", sys.scratch)); break;
         case 3: sys.listAllUsers(); break;
         case 4: return; default: std::cout << "Invalid.\n";
     }
@@ -843,6 +1367,7 @@ void RegularUser::displayMenu(System& sys) {
         std::cout << "1. Browse Events\n2. Search Events\n3. Register for Event\n4. Cancel Registration\n";
         std::cout << "5. View Attendee List\n6. Update Contact Info\n7. Change Password\n8. Logout\n";
         choice = getIntInput("Choice (1-8): ");
+        ScratchArena::Scope request(sys.scratch);
         switch (choice) {
             case 1: sys.viewAllEvents(); break;
             case 2: sys.searchEventsByNameOrDate(); break;
@@ -852,18 +1377,20 @@ void RegularUser::displayMenu(System& sys) {
             case 6: sys.updateCurrentLoggedInUserContactInfo(); break;
             case 7: {
                 std::cout << "--- Change Password ---\n";
-                std::string currPass = getStringInput("Current Password: ");
-                if (currPass != password) { std::cout << "Incorrect.\n"; break; }
-                std::string newPass = getStringInput("New Password (min 6): ");
-                std::string confPass = getStringInput("Confirm New Password: ");
+                std::pmr::string currPass = getStringInput("Current Password: ", sys.scratch);
+                if (std::string_view(currPass) != password) { std::cout << "Incorrect.\n"; break; }
+                std::pmr::string newPass = getStringInput("New Password (min 6): ", sys.scratch);
+                std::pmr::string confPass = getStringInput("Confirm New Password: ", sys.scratch);
                 if (newPass != confPass) { std::cout << "Mismatch.\n"; break; }
                 setPassword(newPass); // User base method
-                if (sys.currentUser) sys.saveUsers(); else std::cout << "Session error.\n";
+                sys.journalRecord("user", *this);
+                if (!sys.currentUser) std::cout << "Session error.\n"; else if (sys.autoSave) sys.saveUsers();
                 break;
             }
             case 8: sys.logout(); return;
             default: std::cout << "Invalid choice.\n";
         }
+        sys.afterRequest();
     }
 }
 
@@ -871,10 +1398,15 @@ void RegularUser::displayMenu(System& sys) {
 void System::run() {
     loadData();
     seedInitialData();
+    openJournalFromEnvironment();
+    openHistoryFromEnvironment();
+    openCatalogFromEnvironment();
     while (true) {
+        afterRequest();
         if (!currentUser) {
             std::cout << "\n===== EMS Main Menu =====\n1. Login\n2. Register\n3. Exit\n";
             int choice = getIntInput("Choice (1-3): ");
+            ScratchArena::Scope request(scratch);
             switch (choice) {
                 case 1: login(); break;
                 case 2: publicRegisterNewUser(); break;
@@ -887,24 +1419,1358 @@ void System::run() {
     }
 }
 
+// --- Batch Mode ---
+// One command per line, no prompts. Mutations are kept in memory and written
+// once when the System is destroyed (or on an explicit "save").
+//   login <user> <pass> | logout | save
+//   create-user <user> <pass> <admin|user> | delete-user <user> | list-users
+//   create-event <name> <YYYY-MM-DD> <HH:MM> <location> <description> <category>
+//   list-events | change-password <new>
+//   search <keyword> | events-between <YYYY-MM-DD> <YYYY-MM-DD>
+//   audience <event-id|category:NAME> [and|or|minus <event-id|category:NAME>]...
+//   join-event <event-id> | leave-event <event-id> | set-contact <info>
+//   check-in <attendee-id> <event-id> | latency (admin: p50/p99/p99.9/max per operation)
+//   trace on|off | trace save <file.json> (admin: Chrome trace of the spans so far)
+//   profile start [hz] | profile stop <file.folded> (admin: CPU samples as folded stacks)
+//   slow-log <ms>[,<op>=<ms>]... | slow-log off (admin: log operations slower than this)
+//   checkpoint (admin: start a new restore point in EMS_HISTORY)
+int System::runScript(std::istream& in) {
+    loadData();
+    seedInitialData();
+    openJournalFromEnvironment();
+    openHistoryFromEnvironment();
+    openCatalogFromEnvironment();
+    autoSave = false;
+    return runCommandScript(in, [this](const CommandLine& cmd) {
+        bool known = executeCommand(cmd);
+        afterRequest();
+        return known;
+    });
+}
+bool System::executeCommand(const CommandLine& cmd) {
+    ScratchArena::Scope request(scratch);
+    std::string_view op = cmd[0];
+    size_t argc = cmd.size() - 1;
+    auto requireAdmin = [this]() {
+        if (!currentUser || currentUser->getRole() != Role::ADMIN) throw std::runtime_error("admin login required");
+    };
+    if (op == "login" && argc == 2) {
+        if (!login(cmd[1], cmd[2])) throw std::runtime_error("login failed");
+        return true;
+    }
+    if (op == "logout" && argc == 0) { logout(); return true; }
+    if (op == "save" && argc == 0) { saveData(); return true; }
+    if (op == "list-users" && argc == 0) { requireAdmin(); listAllUsers(); return true; }
+    if (op == "list-events" && argc == 0) { viewAllEvents(); return true; }
+    if (op == "search" && argc == 1) { showEventList(findEventsByName(cmd[1])); return true; }
+    if ((op == "join-event" || op == "leave-event") && argc == 1) {
+        int eventId;
+        if (!currentUser) throw std::runtime_error("login required");
+        if (!cmd.getInt(1, eventId)) throw std::invalid_argument("event ID must be a number");
+        LatencyScope timer(op == "join-event" ? latency_op::registerEvent : latency_op::cancelRegistration);
+        TraceSpan span(op == "join-event" ? "join-event" : "leave-event", "registration");
+        SlowOp slow(op == "join-event" ? "join-event" : "leave-event");
+        slow.count("eventId", eventId);
+        int attendeeId = profileForUser(*currentUser).attendeeId;
+        bool ok = op == "join-event" ? addRegistration(attendeeId, eventId) : removeRegistration(attendeeId, eventId);
+        if (!ok) throw std::runtime_error(op == "join-event" ? "no such event or already registered" : "not registered");
+        AuditLog::record(op == "join-event" ? AuditType::Registered : AuditType::Unregistered, eventId, attendeeId);
+        return true;
+    }
+    if (op == "set-contact" && argc == 1) {
+        if (!currentUser) throw std::runtime_error("login required");
+        updateContactInfo(profileForUser(*currentUser).attendeeId, cmd[1]);
+        return true;
+    }
+    if (op == "check-in" && argc == 2) {
+        requireAdmin();
+        int attendeeId, eventId;
+        if (!cmd.getInt(1, attendeeId) || !cmd.getInt(2, eventId)) throw std::invalid_argument("IDs must be numbers");
+        if (!checkIn(attendeeId, eventId)) throw std::runtime_error("no such registration");
+        return true;
+    }
+    if (op == "latency" && argc == 0) { requireAdmin(); LatencyStats::report(std::cout); return true; }
+    if (op == "trace" && (argc == 1 || argc == 2)) {
+        requireAdmin();
+        if (argc == 1 && (cmd[1] == "on" || cmd[1] == "off")) { Tracer::enable(cmd[1] == "on"); return true; }
+        size_t spans = 0;
+        if (argc == 2 && cmd[1] == "save") {
+            if (!Tracer::writeChromeJson(cmd.str(2), &spans)) throw std::runtime_error("cannot write trace file");
+            std::cout << "Wrote " << spans << " spans to " << cmd[2] << ".\n";
+            return true;
+        }
+        return false;
+    }
+    if (op == "profile" && argc >= 1 && argc <= 2) {
+        requireAdmin();
+        if (cmd[1] == "start") {
+            int hz = 99;
+            if (argc == 2 && !cmd.getInt(2, hz)) throw std::invalid_argument("rate must be a number");
+            if (!SamplingProfiler::start(hz)) throw std::runtime_error("profiler already running or unsupported here");
+            return true;
+        }
+        if (cmd[1] == "stop" && argc == 2) {
+            if (!SamplingProfiler::running()) throw std::runtime_error("profiler is not running");
+            size_t samples = SamplingProfiler::stop(cmd.str(2));
+            std::cout << "Wrote " << samples << " samples to " << cmd[2] << ".\n";
+            return true;
+        }
+        return false;
+    }
+    if (op == "slow-log" && argc == 1) {
+        requireAdmin();
+        if (!SlowLog::configure(cmd[1])) throw std::invalid_argument("expected <ms>[,<op>=<ms>]... or off");
+        return true;
+    }
+    if (op == "checkpoint" && argc == 0) {
+        requireAdmin();
+        if (historyDir.empty()) throw std::runtime_error("history is off (set EMS_HISTORY)");
+        checkpoint();
+        std::cout << "Checkpoint " << lastCheckpointMs << " written.\n";
+        return true;
+    }
+    if (op == "audience" && argc >= 1) { requireAdmin(); showAudience(evaluateAudience(cmd, 1)); return true; }
+    if (op == "events-between" && argc == 2) {
+        Date from, to;
+        if (!parseDate(cmd[1], from) || !parseDate(cmd[2], to)) throw std::invalid_argument("invalid date");
+        showEventList(findEventsBetween(from, to));
+        return true;
+    }
+    if (op == "create-user" && argc == 3) {
+        requireAdmin();
+        Role r = cmd[3] == "admin" ? Role::ADMIN : cmd[3] == "user" ? Role::REGULAR_USER : Role::NONE;
+        if (!createUserAccount(cmd.str(1), cmd.str(2), r)) throw std::runtime_error("user rejected");
+        return true;
+    }
+    if (op == "delete-user" && argc == 1) {
+        requireAdmin();
+        if (!deleteUserAccount(cmd[1])) throw std::runtime_error("user not deleted");
+        return true;
+    }
+    if (op == "create-event" && argc == 6) {
+        requireAdmin();
+        if (!createEvent(cmd[1], cmd[2], cmd[3], cmd[4], cmd[5], cmd[6])) throw std::runtime_error("event rejected");
+        return true;
+    }
+    if (op == "change-password" && argc == 1) {
+        if (!currentUser) throw std::runtime_error("login required");
+        currentUser->setPassword(cmd[1]);
+        journalRecord("user", *currentUser);
+        return true;
+    }
+    return false;
+}
+
+// --- Journal Shipping (EMS_JOURNAL, --replica <journal> [poll-ms]) ---
+// The primary starts a new journal after loading: "begin", one entry per
+// record (the snapshot), "ready", then every change as it happens. Kinds:
+//   user | event | item | attendee | reg   <record>   insert or replace
+//   user- <user-id> | reg- <attendee-id>,<event-id>   delete
+void System::openJournalFromEnvironment() {
+    const char* path = std::getenv("EMS_JOURNAL");
+    if (!path || !*path || replica) return;
+    if (!journal.open(path)) { std::cerr << "Warn: Cannot open journal '" << path << "'.\n"; return; }
+    auto snapshot = [this](std::string_view kind, const auto& rec) {
+        journal.append(kind, [&](OutputBuffer& out) { appendText(out, rec); });
+    };
+    journal.append("begin");
+    for (const auto* user : users) if (user) snapshot("user", *user);
+    for (const auto& event : events) snapshot("event", event);
+    for (const auto& item : inventory) snapshot("item", item);
+    for (const auto& attendee : allAttendees) snapshot("attendee", attendee);
+    for (const auto& registration : registrations) snapshot("reg", registration);
+    journal.append("ready");
+}
+void System::journalKey(std::string_view kind, int a, int b) {
+    auto write = [&](OutputBuffer& out) {
+        out << a;
+        if (kind == "reg-") out << ',' << b;
+    };
+    if (journal.isOpen()) journal.append(kind, write);
+    if (history.isOpen()) history.append(kind, write);
+    noteChange(kind);
+}
+// Throws std::invalid_argument on a record that does not parse
+void System::applyJournalEntry(const JournalEntry& entry) {
+    std::string_view kind = entry.kind;
+    const CsvFields& f = entry.record;
+    auto intField = [&](size_t i) {
+        int value;
+        if (i >= f.size() || !schema_detail::parseInt(f[i], value)) throw std::invalid_argument("bad key");
+        return value;
+    };
+    if (kind == "begin") { clearData(); return; }
+    if (kind == "ready") return;
+    if (kind == "user" || kind == "user-") {
+        int userId = kind == "user" ? 0 : intField(0);
+        User* incoming = kind == "user" ? User::fromFields(f) : nullptr;
+        if (incoming) userId = incoming->getUserId();
+        auto it = std::find_if(users.begin(), users.end(), [&](const User* u) { return u && u->getUserId() == userId; });
+        if (it != users.end()) {
+            auto indexed = userIndex.find((*it)->getUsername());
+            if (indexed != userIndex.end() && indexed->second == *it) userIndex.erase(indexed);
+            delete *it;
+            users.erase(it);
+        }
+        if (incoming) addUser(incoming);
+        return;
+    }
+    if (kind == "event") {
+        Event event = Event::fromFields(f);
+        if (Event* existing = findEventById(event.eventId)) *existing = std::move(event);
+        else events.push_back(std::move(event));
+        return;
+    }
+    if (kind == "item") {
+        InventoryItem item = InventoryItem::fromFields(f);
+        if (InventoryItem* existing = findInventoryItemById(item.itemId)) *existing = std::move(item);
+        else inventory.push_back(std::move(item));
+        return;
+    }
+    if (kind == "attendee") {
+        Attendee attendee = Attendee::fromFields(f);
+        if (Attendee* existing = findAttendeeInMasterList(attendee.attendeeId)) *existing = std::move(attendee);
+        else addAttendee(std::move(attendee));
+        return;
+    }
+    if (kind == "reg") {
+        Registration r;
+        parseFields(f, r);
+        if (Registration* existing = findRegistration(r.attendeeId, r.eventId)) existing->flags = r.flags;
+        else addRegistration(r.attendeeId, r.eventId, r.flags);
+        return;
+    }
+    if (kind == "reg-") { removeRegistration(intField(0), intField(1)); return; }
+    throw std::invalid_argument("unknown kind");
+}
+// Follows the journal from a background thread (every pollMs) and answers
+// read-only batch commands from in: list-events, search, events-between, and
+// status (the last entry applied and how far behind it is). Reads see state
+// at least as new as the last poll, so lag is bounded by pollMs plus the
+// time to apply what arrived.
+int System::runReplica(const std::string& journalPath, int pollMs, std::istream& in) {
+    replica = true;
+    autoSave = false;
+    JournalTail tail(journalPath);
+    std::mutex stateLock; // Held while applying entries or answering a command
+    uint64_t appliedSeq = 0, appliedMs = 0, polledMs = 0;
+    auto catchUp = [&] {
+        tail.poll([&](const JournalEntry& entry) {
+            try {
+                applyJournalEntry(entry);
+            } catch (const std::exception& e) {
+                std::cerr << "Warning: Skipping journal entry " << entry.seq << " (" << e.what() << ").\n";
+            }
+            appliedSeq = entry.seq;
+            appliedMs = entry.timeMs;
+        }, [](std::string_view text) { std::cerr << "Warning: Skipping journal line '" << text << "'.\n"; });
+        polledMs = JournalWriter::nowMs();
+    };
+    {
+        std::lock_guard<std::mutex> lock(stateLock);
+        catchUp();
+    }
+    std::atomic<bool> stop{false};
+    std::thread follower([&] {
+        while (!stop.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(pollMs));
+            std::lock_guard<std::mutex> lock(stateLock);
+            catchUp();
+        }
+    });
+    int failures = runCommandScript(in, [&](const CommandLine& cmd) {
+        std::lock_guard<std::mutex> lock(stateLock);
+        std::string_view op = cmd[0];
+        if (op == "status" && cmd.size() == 1) {
+            uint64_t now = JournalWriter::nowMs();
+            std::cout << "Replica of " << journalPath << ": entry " << appliedSeq << ", written "
+                      << (appliedMs ? now - appliedMs : 0) << " ms ago; polled " << now - polledMs << " ms ago; "
+                      << users.size() << " users, " << events.size() << " events, " << registrations.size() << " registrations.\n";
+            return true;
+        }
+        if (op == "list-events" || op == "search" || op == "events-between") return executeCommand(cmd);
+        throw std::runtime_error("read-only replica");
+    });
+    stop.store(true);
+    follower.join();
+    return failures;
+}
+
+// --- Point-in-Time Restore (EMS_HISTORY, --restore <history> <time>) ---
+// With EMS_HISTORY=<dir>, every run starts with a checkpoint: the data files
+// are copied to <dir>/<ms>/ and the changes that follow are journaled to
+// <dir>/<ms>/journal.log (the replica journal's format, without a snapshot).
+// A new checkpoint is taken every kCheckpointEvery changes and on the admin
+// "checkpoint" command, and <dir>/index.txt lists the complete ones in time
+// order. Restoring to time T loads the last checkpoint at or before T and
+// replays its journal up to T, so the work is bounded by the distance to
+// that checkpoint rather than by the whole history.
+void System::openHistoryFromEnvironment() {
+    const char* path = std::getenv("EMS_HISTORY");
+    if (!path || !*path || replica) return;
+    std::error_code ec;
+    historyDir = std::filesystem::absolute(path, ec).string();
+    if (ec) historyDir = path;
+    try {
+        checkpoint();
+    } catch (const std::exception& e) {
+        std::cerr << "Warn: History disabled (" << e.what() << ").\n";
+        historyDir.clear();
+    }
+}
+// Throws std::runtime_error if the snapshot cannot be written; the previous
+// journal is closed either way
+void System::checkpoint() {
+    if (historyDir.empty()) return;
+    history.close();
+    uint64_t ms = std::max(JournalWriter::nowMs(), lastCheckpointMs + 1); // Names stay unique and ordered
+    std::string dir = historyDir + "/" + std::to_string(ms);
+    std::filesystem::create_directories(dir);
+    writeShard(dir, 0, 1); // The whole data set is shard 0 of 1
+    if (!history.open(dir + "/journal.log")) throw std::runtime_error("cannot create " + dir + "/journal.log");
+    std::ofstream index(historyDir + "/index.txt", std::ios::app); // Listed only once complete
+    index << ms << '\n';
+    if (!index.flush()) throw std::runtime_error("cannot append to " + historyDir + "/index.txt");
+    lastCheckpointMs = ms;
+}
+// Rebuilds the state as of timeMs and writes it to the data files in the
+// current directory. Returns 0 on success.
+int System::restoreToTime(const std::string& historyPath, uint64_t timeMs) {
+    namespace fs = std::filesystem;
+    std::vector<uint64_t> checkpoints;
+    {
+        std::ifstream index(historyPath + "/index.txt");
+        index.imbue(std::locale::classic());
+        uint64_t ms;
+        while (index >> ms) checkpoints.push_back(ms);
+    }
+    // Appended in time order, so the nearest checkpoint is a binary search away
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), timeMs);
+    if (it == checkpoints.begin()) {
+        std::cerr << "Error: No checkpoint in '" << historyPath << "' at or before that time.\n";
+        return 1;
+    }
+    std::string dir = historyPath + "/" + std::to_string(*--it);
+    System restored;
+    restored.autoSave = false;
+    fs::path home = fs::current_path();
+    try {
+        fs::current_path(dir);
+    } catch (const std::exception&) {
+        std::cerr << "Error: Checkpoint " << dir << " is missing.\n";
+        restored.replica = true; // Nothing was loaded: leave the data files alone
+        return 1;
+    }
+    restored.loadData();
+    fs::current_path(home);
+    size_t applied = 0, later = 0;
+    JournalTail tail(dir + "/journal.log");
+    tail.poll([&](const JournalEntry& entry) {
+        if (later || entry.timeMs > timeMs) { ++later; return; }
+        try {
+            restored.applyJournalEntry(entry);
+            ++applied;
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: Skipping journal entry " << entry.seq << " (" << e.what() << ").\n";
+        }
+    }, [](std::string_view text) { std::cerr << "Warning: Skipping journal line '" << text << "'.\n"; });
+    std::cout << "Restored checkpoint " << dir << " plus " << applied << " change(s); " << later
+              << " later change(s) not applied. " << restored.users.size() << " users, " << restored.events.size()
+              << " events, " << restored.registrations.size() << " registrations.\n";
+    return 0; // ~System writes the data files
+}
+// "<epoch-ms>" or "<YYYY-MM-DD> [HH:MM]" in local time
+static bool parseRestoreTime(int argc, char* argv[], int first, uint64_t& ms) {
+    std::string_view text = argv[first];
+    if (!text.empty() && text.find_first_not_of("0123456789") == std::string_view::npos && argc == first + 1) {
+        ms = std::strtoull(argv[first], nullptr, 10);
+        return true;
+    }
+    Date date;
+    TimeOfDay time;
+    if (!parseDate(text, date) || (argc > first + 1 && !parseTime(argv[first + 1], time)) || argc > first + 2) return false;
+    std::tm local = {};
+    local.tm_year = int(date.year()) - 1900;
+    local.tm_mon = int(date.month()) - 1;
+    local.tm_mday = int(date.day());
+    local.tm_hour = int(time.hour());
+    local.tm_min = int(time.minute());
+    local.tm_isdst = -1;
+    std::time_t seconds = std::mktime(&local);
+    if (seconds == std::time_t(-1)) return false;
+    ms = uint64_t(seconds) * 1000;
+    return true;
+}
+
+// --- Shared-Memory Catalog (EMS_CATALOG=/name, --catalog <name>) ---
+// The primary republishes the event list (see shm_catalog.h) after every
+// menu action or batch command that created an event or changed a
+// registration; co-located readers map it instead of loading events.txt.
+void System::openCatalogFromEnvironment() {
+    const char* name = std::getenv("EMS_CATALOG");
+    if (!name || !*name || replica) return;
+    if (!catalog.open(name)) { std::cerr << "Warn: Cannot open shared catalog '" << name << "'.\n"; return; }
+    publishCatalog();
+}
+void System::publishCatalog() {
+    catalogStale = false;
+    if (!catalog.isOpen()) return;
+    std::vector<const Event*> byId;
+    byId.reserve(events.size());
+    for (const auto& event : events) byId.push_back(&event);
+    std::sort(byId.begin(), byId.end(), [](const Event* a, const Event* b) { return a->eventId < b->eventId; });
+    CatalogBuilder builder;
+    for (const Event* e : byId)
+        builder.addEvent(e->eventId, e->date.packed, e->time.minutes, static_cast<uint32_t>(e->attendeeIds.size()),
+                         e->name, e->location, e->category, e->getStatusString(), e->description);
+    if (!catalog.publish(builder, JournalWriter::nowMs())) std::cerr << "Warn: Cannot publish the shared catalog.\n";
+}
+// A reader: prints the catalog currently published under name
+int printSharedCatalog(const std::string& name) {
+    ShmCatalogReader reader;
+    if (!reader.open(name)) { std::cerr << "Cannot open shared catalog '" << name << "'.\n"; return 1; }
+    OutputBuffer page;
+    bool ok = reader.read([&](const CatalogView& catalog) {
+        page.clear(); // A retried read starts over
+        page << "Catalog version " << catalog.version() << ", " << catalog.size() << " event(s).\n";
+        for (size_t i = 0; i < catalog.size(); ++i) {
+            const CatalogEvent& e = catalog[i];
+            Date date;
+            date.packed = e.date;
+            TimeOfDay time;
+            time.minutes = static_cast<uint16_t>(e.minutes);
+            page << "Event ID: " << e.eventId << "\n  Name: " << catalog.text(e.name) << "\n  Date: " << date.iso()
+                 << ", Time: " << time.hhmm() << "\n  Location: " << catalog.text(e.location) << "\n  Category: "
+                 << catalog.text(e.category) << "\n  Status: " << catalog.text(e.status) << "\n  Description: "
+                 << catalog.text(e.description) << "\n  Attendees: " << e.attendees << "\n-------------------\n";
+        }
+    });
+    if (!ok) { std::cerr << "Nothing published in '" << name << "' yet.\n"; return 1; }
+    page.flushTo(std::cout);
+    return 0;
+}
+
+// --- Sharding (--shards <N>) ---
+// Events live on shard (event ID mod N), together with their registrations;
+// users, inventory and attendee profiles are copied to every shard. Each
+// shard is a worker process with its own data directory (shard-<i>/), and
+// the router reads batch commands from stdin and forwards them:
+//   join-event, leave-event, check-in        the event's shard
+//   create-event                             round-robin; the worker picks
+//                                            an ID in its own class
+//   login, logout, save, create-user, delete-user,
+//   change-password, set-contact             every shard (output of shard 0)
+//   list-users                               shard 0
+//   list-events, search, events-between      every shard, merged
+// Up to kShardWindow commands are in flight at once; results and errors are
+// still reported in script order. Worker requests are "x <command>" (run it,
+// return its output) or "q <query>" (return the matching events, each as
+// "<sort-key> <event-id> <length>\n<rendered event>").
+constexpr size_t kShardWindow = 64;
+
+// Writes the part of the loaded data that belongs to one shard into dir
+void System::writeShard(const std::string& dir, int shard, int shards) {
+    auto write = [&](const std::string& file) {
+        if (!fileBuffer.writeFile(dir + "/" + file)) throw std::runtime_error("cannot write " + dir + "/" + file);
+        fileBuffer.clear();
+    };
+    fileBuffer.clear();
+    for (const auto* user : users) if (user) { appendText(fileBuffer, *user); fileBuffer << '\n'; }
+    write(USERS_FILE);
+    for (const auto& event : events)
+        if (shardOf(event.eventId, shards) == shard) { appendText(fileBuffer, event); fileBuffer << '\n'; }
+    write(EVENTS_FILE);
+    for (const auto& item : inventory) { appendText(fileBuffer, item); fileBuffer << '\n'; }
+    write(INVENTORY_FILE);
+    for (const auto& attendee : allAttendees) { appendText(fileBuffer, attendee); fileBuffer << '\n'; }
+    write(ATTENDEES_FILE);
+    for (const auto& registration : registrations)
+        if (shardOf(registration.eventId, shards) == shard) { appendText(fileBuffer, registration); fileBuffer << '\n'; }
+    write(REGISTRATIONS_FILE);
+}
+// Serves requests from the router until it closes the channel. Runs in the
+// shard's directory; files are written when the System is destroyed.
+int System::runShardWorker(int shard, int shards, ShardChannel& channel) {
+    autoSave = false;
+    Event::idClass = IdClass{shards, shard};
+    Attendee::idClass = IdClass{shards, shard};
+    loadData(); // No seeding: the users came with the split
+    Event::nextEventId = Event::idClass.align(Event::nextEventId);
+    Attendee::nextAttendeeId = Attendee::idClass.align(Attendee::nextAttendeeId);
+    std::string line, text, error;
+    std::ostringstream captured;
+    OutputBuffer items;
+    CommandLine cmd;
+    while (channel.readLine(line)) {
+        if (line.size() > 2) text.assign(line, 2);
+        if (line.size() < 3 || line[1] != ' ' || !cmd.parse(text) || cmd.empty()) {
+            channel.sendResponse("err", "malformed request\n");
+            continue;
+        }
+        std::string_view op = cmd[0];
+        if (line[0] == 'q') {
+            ScratchArena::Scope request(scratch);
+            std::pmr::vector<const Event*> found(scratch.resource());
+            Date from, to;
+            bool byId = op == "list-events" && cmd.size() == 1;
+            if (byId) for (const auto& event : events) found.push_back(&event);
+            else if (op == "search" && cmd.size() == 2) found = findEventsByName(cmd[1]);
+            else if (op == "events-between" && cmd.size() == 3 && parseDate(cmd[1], from) && parseDate(cmd[2], to))
+                found = findEventsBetween(from, to);
+            else if (op == "events-between" && cmd.size() == 3) { channel.sendResponse("err", "invalid date\n"); continue; }
+            else { channel.sendResponse("bad", ""); continue; }
+            items.clear();
+            for (const Event* event : found) {
+                event->displayDetails(*this, pageBuffer);
+                pageBuffer << "-------------------\n";
+                items << (byId ? uint64_t(event->eventId) : dateTimeKey(event->date, event->time)) << ' '
+                      << event->eventId << ' ' << pageBuffer.size() << '\n' << pageBuffer.view();
+                pageBuffer.clear();
+            }
+            channel.sendResponse("ok", items.view());
+            continue;
+        }
+        // Run the command as the batch mode would, keeping what it prints
+        captured.str("");
+        std::streambuf* saved = std::cout.rdbuf(captured.rdbuf());
+        const char* status = "ok";
+        try {
+            if (!executeCommand(cmd)) status = "bad";
+        } catch (const std::exception& e) {
+            status = "err";
+            error = e.what();
+        }
+        std::cout.rdbuf(saved);
+        // An error's payload is its message line, then the command's output
+        channel.sendResponse(status, std::string_view(status) == "err" ? error + '\n' + captured.str() : captured.str());
+    }
+    return 0;
+}
+// Splits the data in the current directory on first use (recording N in
+// shard-map.txt), starts the workers and routes the commands read from in.
+// Returns the number of commands that failed.
+int System::runShardRouter(int shards, std::istream& in) {
+#ifdef SHARD_CHANNEL_SUPPORTED
+    namespace fs = std::filesystem;
+    auto shardDir = [](int i) { return "shard-" + std::to_string(i); };
+    {
+        std::ifstream map("shard-map.txt");
+        std::string word;
+        int recorded = 0;
+        if (map >> word >> recorded) {
+            if (word != "shards" || recorded != shards) {
+                std::cerr << "Error: The data is split into " << recorded << " shards (shard-map.txt), not " << shards << ".\n";
+                return 1;
+            }
+        } else {
+            System source;
+            source.loadData();
+            source.seedInitialData();
+            try {
+                for (int i = 0; i < shards; ++i) {
+                    fs::create_directories(shardDir(i));
+                    source.writeShard(shardDir(i), i, shards);
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Cannot split the data (" << e.what() << ").\n";
+                return 1;
+            }
+            std::ofstream("shard-map.txt") << "shards " << shards << "\n";
+            std::cout << "Split the data into " << shards << " shards by event ID.\n";
+        }
+    }
+    std::cout.flush(); // Or the workers would inherit (and print) buffered output
+    std::signal(SIGPIPE, SIG_IGN); // A dead worker shows up as a failed write
+    std::vector<ShardChannel> channels;
+    std::vector<pid_t> workers;
+    for (int i = 0; i < shards; ++i) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) { std::cerr << "Error: socketpair failed.\n"; return 1; }
+        pid_t pid = fork();
+        if (pid < 0) { std::cerr << "Error: fork failed.\n"; return 1; }
+        if (pid == 0) {
+            ::close(fds[0]);
+            for (auto& other : channels) other.close(); // So earlier workers see EOF when the router goes
+            int code = 1;
+            try {
+                fs::current_path(shardDir(i));
+                ShardChannel channel(fds[1]);
+                System worker;
+                code = worker.runShardWorker(i, shards, channel);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Shard " << i << ": " << e.what() << "\n";
+            }
+            std::exit(code); // After ~System's save
+        }
+        ::close(fds[1]);
+        channels.emplace_back(fds[0]);
+        workers.push_back(pid);
+    }
+
+    struct Pending {
+        int lineNo = 0;
+        char mode = 'x';          // 'x': print the first target's output; 'q': merge events
+        std::string op;
+        std::vector<int> targets;
+        std::string error;        // Set by the router itself: nothing was sent
+    };
+    std::deque<Pending> inFlight;
+    int failures = 0;
+    auto fail = [&](int lineNo, std::string_view message) {
+        std::cerr << "Script line " << lineNo << ": " << message << "\n";
+        ++failures;
+    };
+    struct Item { uint64_t key; int eventId; std::string text; };
+    std::vector<Item> merged;
+    OutputBuffer page;
+    std::string status, payload;
+    auto complete = [&](const Pending& p) {
+        if (!p.error.empty()) { fail(p.lineNo, p.error); return; }
+        std::string error;
+        bool unknown = false;
+        merged.clear();
+        for (int t : p.targets) {
+            if (!channels[t].readResponse(status, payload)) {
+                if (error.empty()) error = "shard " + std::to_string(t) + " stopped responding";
+                continue;
+            }
+            if (status == "err") {
+                size_t newline = payload.find('\n');
+                if (error.empty()) error = payload.substr(0, newline);
+                if (t == p.targets.front() && newline != std::string::npos) std::cout << std::string_view(payload).substr(newline + 1);
+            } else if (status == "bad") {
+                unknown = true;
+                if (t == p.targets.front()) std::cout << payload;
+            } else if (p.mode == 'x') {
+                if (t == p.targets.front()) std::cout << payload;
+            } else {
+                std::string_view rest = payload;
+                while (!rest.empty()) {
+                    size_t newline = rest.find('\n');
+                    if (newline == std::string_view::npos) break;
+                    std::istringstream header(std::string(rest.substr(0, newline)));
+                    header.imbue(std::locale::classic());
+                    Item item{};
+                    size_t length = 0;
+                    if (!(header >> item.key >> item.eventId >> length) || newline + 1 + length > rest.size()) break;
+                    item.text.assign(rest.substr(newline + 1, length));
+                    merged.push_back(std::move(item));
+                    rest.remove_prefix(newline + 1 + length);
+                }
+            }
+        }
+        if (!error.empty()) { fail(p.lineNo, error); return; }
+        if (unknown) { fail(p.lineNo, "unknown command or bad arguments: " + p.op); return; }
+        if (p.mode != 'q') return;
+        std::sort(merged.begin(), merged.end(), [](const Item& a, const Item& b) {
+            return a.key != b.key ? a.key < b.key : a.eventId < b.eventId;
+        });
+        if (p.op == "list-events") {
+            page << "\n--- All Events ---\n";
+            if (merged.empty()) page << "No events.\n";
+        } else {
+            page << "Found " << merged.size() << " event(s).\n";
+        }
+        for (const Item& item : merged) page << item.text;
+        page.flushTo(std::cout);
+    };
+
+    std::string line, request;
+    CommandLine cmd;
+    int lineNo = 0, nextCreate = 0;
+    while (std::getline(in, line)) {
+        Pending p;
+        p.lineNo = ++lineNo;
+        if (!cmd.parse(line)) {
+            p.error = "unterminated quote";
+        } else if (cmd.empty()) {
+            continue;
+        } else if (cmd[0] == "exit" || cmd[0] == "quit") {
+            break;
+        } else {
+            std::string_view op = cmd[0];
+            size_t argc = cmd.size() - 1;
+            p.op = cmd.str(0);
+            int eventId = 0;
+            if (op == "login" || op == "logout" || op == "save" || op == "create-user" || op == "delete-user"
+                || op == "change-password" || op == "set-contact") {
+                for (int i = 0; i < shards; ++i) p.targets.push_back(i);
+            } else if ((op == "join-event" || op == "leave-event") && argc == 1) {
+                if (cmd.getInt(1, eventId)) p.targets.push_back(shardOf(eventId, shards));
+                else p.error = "event ID must be a number";
+            } else if (op == "check-in" && argc == 2) {
+                if (cmd.getInt(2, eventId)) p.targets.push_back(shardOf(eventId, shards));
+                else p.error = "IDs must be numbers";
+            } else if (op == "create-event") {
+                p.targets.push_back(nextCreate++ % shards);
+            } else if (op == "list-users") {
+                p.targets.push_back(0);
+            } else if (op == "list-events" || op == "search" || op == "events-between") {
+                p.mode = 'q';
+                for (int i = 0; i < shards; ++i) p.targets.push_back(i);
+            } else {
+                p.error = "not available through the shard router: " + p.op;
+            }
+            if (p.error.empty()) {
+                // Re-quote every token so the worker parses exactly these
+                request.assign(1, p.mode);
+                for (size_t i = 0; i < cmd.size(); ++i) {
+                    request += " \"";
+                    for (char c : cmd[i]) { if (c == '"') request += '"'; request += c; }
+                    request += '"';
+                }
+                request += '\n';
+                for (int t : p.targets) channels[t].writeAll(request);
+            }
+        }
+        inFlight.push_back(std::move(p));
+        if (inFlight.size() >= kShardWindow) { complete(inFlight.front()); inFlight.pop_front(); }
+    }
+    while (!inFlight.empty()) { complete(inFlight.front()); inFlight.pop_front(); }
+    for (auto& channel : channels) channel.close();
+    for (pid_t pid : workers) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) std::cerr << "Warning: Shard worker " << pid << " failed.\n";
+    }
+    return failures;
+#else
+    (void)shards; (void)in;
+    std::cerr << "Error: --shards needs a POSIX system.\n";
+    return 1;
+#endif
+}
+
+// --- Tenants (--tenants <dir> [max-resident]) ---
+// One process hosting many isolated stores, one per organization, each in
+// <dir>/<tenant>/ with the usual data files. tenants.txt in <dir> lists the
+// tenants and their quotas. Commands come from stdin, in batch syntax:
+//   add-tenant <name> <admin> <password> [max-users max-events max-registrations]
+//                     a new store whose only account is that admin (0 = no limit)
+//   use <name>        later commands go to this tenant's store
+//   tenants           per-tenant counts, quota rejections, command latency
+//                     and heap bytes allocated by the last load
+//   flush             wait until every pending save is on disk
+//   anything else     a batch command (see runScript) for the current tenant,
+//                     except the process-wide latency, trace, profile and
+//                     slow-log, which one tenant must not read or reconfigure
+// The stores share one scratch arena (commands run one at a time) and one
+// WriteBehindPool for their saves. Only the max-resident most recently used
+// stores stay loaded; the rest are saved and dropped (ending their login
+// session) until next used, so an idle tenant costs its registry entry.
+// Record IDs come from the process-wide counters, so they are unique across
+// tenants rather than dense within one.
+struct TenantRecord {
+    std::string name;
+    int maxUsers = 0;
+    int maxEvents = 0;
+    int maxRegistrations = 0;
+
+    static constexpr auto schema() {
+        return makeSchema(field("name", &TenantRecord::name), field("maxUsers", &TenantRecord::maxUsers),
+                          field("maxEvents", &TenantRecord::maxEvents),
+                          field("maxRegistrations", &TenantRecord::maxRegistrations));
+    }
+};
+
+class TenantHost {
+private:
+    struct Tenant {
+        TenantRecord quota;
+        std::unique_ptr<System> store; // Null while not resident
+        uint64_t lastUsed = 0;
+        size_t users = 0, events = 0, registrations = 0; // As of the last command
+        uint64_t commands = 0, failures = 0, rejected = 0, loads = 0;
+        uint64_t totalUs = 0, maxUs = 0;
+        size_t loadBytes = 0;
+    };
+
+    std::string root;
+    size_t maxResident;
+    ScratchArena scratch;   // Shared by every store; declared before them so it outlives them
+    WriteBehindPool writer; // Likewise: the stores' final saves go through it
+    std::map<std::string, Tenant, std::less<>> tenants;
+    Tenant* current = nullptr;
+    uint64_t clock = 0;
+
+    std::string registryPath() const { return root + "/tenants.txt"; }
+
+    static bool validName(std::string_view name) {
+        return !name.empty() && name.size() <= 64 && std::all_of(name.begin(), name.end(), [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_';
+        });
+    }
+
+    void remember(Tenant& t) {
+        t.users = t.store->users.size();
+        t.events = t.store->events.size();
+        t.registrations = t.store->registrations.size();
+    }
+
+    // Loads t's store, dropping the least recently used one if too many are resident
+    System& open(Tenant& t) {
+        t.lastUsed = ++clock;
+        if (t.store) return *t.store;
+        size_t resident = 0;
+        Tenant* oldest = nullptr;
+        for (auto& [name, other] : tenants) {
+            if (!other.store) continue;
+            ++resident;
+            if (!oldest || other.lastUsed < oldest->lastUsed) oldest = &other;
+        }
+        if (oldest && resident >= maxResident) {
+            remember(*oldest);
+            oldest->store.reset(); // ~System saves through the writer
+        }
+        std::string dir = root + "/" + t.quota.name + "/";
+        writer.flush(dir); // Its last save (if it was dropped earlier) must land before loading
+        AllocationScope allocations;
+        t.store = std::make_unique<System>(dir, &scratch);
+        t.store->writeBehind = &writer;
+        t.store->autoSave = false;
+        t.store->loadData();
+        t.loadBytes = allocations.bytes();
+        ++t.loads;
+        remember(t);
+        return *t.store;
+    }
+
+    static void checkQuota(int limit, size_t used, const char* what) {
+        if (limit > 0 && used >= size_t(limit))
+            throw std::runtime_error(std::string("tenant quota reached: ") + std::to_string(limit) + " " + what);
+    }
+
+    static bool processWide(std::string_view op) {
+        return op == "latency" || op == "trace" || op == "profile" || op == "slow-log";
+    }
+
+    bool runTenantCommand(const CommandLine& cmd) {
+        if (!current) throw std::runtime_error("no tenant selected (use <name>)");
+        std::string_view op = cmd[0];
+        if (processWide(op)) throw std::runtime_error("not available to tenants");
+        Tenant& t = *current;
+        System& store = open(t);
+        try {
+            if (op == "create-user") checkQuota(t.quota.maxUsers, store.users.size(), "users");
+            if (op == "create-event") checkQuota(t.quota.maxEvents, store.events.size(), "events");
+            if (op == "join-event") checkQuota(t.quota.maxRegistrations, store.registrations.size(), "registrations");
+        } catch (const std::exception&) {
+            ++t.rejected;
+            throw;
+        }
+        auto start = std::chrono::steady_clock::now();
+        bool known = false;
+        try {
+            known = store.executeCommand(cmd);
+        } catch (const std::exception&) {
+            known = true;
+            ++t.failures;
+            record(t, start);
+            throw;
+        }
+        if (!known) ++t.failures;
+        record(t, start);
+        return known;
+    }
+
+    void record(Tenant& t, std::chrono::steady_clock::time_point start) {
+        uint64_t us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        ++t.commands;
+        t.totalUs += us;
+        t.maxUs = std::max(t.maxUs, us);
+        remember(t);
+    }
+
+    void report(std::ostream& os) {
+        std::ostringstream table;
+        table.imbue(std::locale::classic());
+        table << std::left << std::setw(16) << "Tenant" << std::right << std::setw(9) << "Resident" << std::setw(7)
+              << "Users" << std::setw(8) << "Events" << std::setw(8) << "Regs" << std::setw(8) << "Cmds"
+              << std::setw(7) << "Fail" << std::setw(7) << "Quota" << std::setw(9) << "Avg us" << std::setw(9)
+              << "Max us" << std::setw(10) << "Load KB" << '\n';
+        for (const auto& [name, t] : tenants) {
+            table << std::left << std::setw(16) << name << std::right << std::setw(9) << (t.store ? "yes" : "no")
+                  << std::setw(7) << t.users << std::setw(8) << t.events << std::setw(8) << t.registrations
+                  << std::setw(8) << t.commands << std::setw(7) << t.failures << std::setw(7) << t.rejected
+                  << std::setw(9) << (t.commands ? t.totalUs / t.commands : 0) << std::setw(9) << t.maxUs
+                  << std::setw(10) << (t.loadBytes + 1023) / 1024 << '\n';
+        }
+        WriteBehindPool::Stats io = writer.stats();
+        table << tenants.size() << " tenants; files written " << io.written << ", coalesced " << io.coalesced
+              << ", failed " << io.failed << ", pending " << io.pending << ".\n";
+        os << table.str();
+    }
+
+public:
+    TenantHost(std::string directory, size_t residentLimit)
+        : root(std::move(directory)), maxResident(std::max<size_t>(residentLimit, 1)), writer(2) {}
+
+    // Reads tenants.txt; false if it exists but cannot be parsed
+    bool loadRegistry() {
+        try {
+            forEachRecordInFile(registryPath(), [this](const CsvFields& f) {
+                TenantRecord record;
+                parseFields(f, record);
+                if (!validName(record.name)) throw std::invalid_argument("bad tenant name");
+                tenants[record.name].quota = record;
+            });
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << registryPath() << ": " << e.what() << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    bool execute(const CommandLine& cmd) {
+        std::string_view op = cmd[0];
+        size_t argc = cmd.size() - 1;
+        if (op == "use" && argc == 1) {
+            auto it = tenants.find(cmd[1]);
+            if (it == tenants.end()) throw std::runtime_error("no such tenant");
+            current = &it->second;
+            return true;
+        }
+        if (op == "add-tenant" && (argc == 3 || argc == 6)) {
+            TenantRecord record;
+            record.name = cmd.str(1);
+            if (!validName(record.name)) throw std::invalid_argument("tenant names are letters, digits, '-' and '_'");
+            if (tenants.count(record.name)) throw std::runtime_error("tenant exists");
+            if (cmd[3].size() < 6) throw std::invalid_argument("admin password must be at least 6 characters");
+            if (argc == 6 && (!cmd.getInt(4, record.maxUsers) || !cmd.getInt(5, record.maxEvents)
+                              || !cmd.getInt(6, record.maxRegistrations)))
+                throw std::invalid_argument("quotas must be numbers");
+            std::filesystem::create_directories(root + "/" + record.name);
+            OutputBuffer line;
+            appendText(line, record);
+            line << '\n';
+            std::ofstream registry(registryPath(), std::ios::app | std::ios::binary);
+            if (!registry.write(line.data(), static_cast<std::streamsize>(line.size())).flush())
+                throw std::runtime_error("cannot update " + registryPath());
+            Tenant& t = tenants[record.name];
+            t.quota = std::move(record);
+            System& store = open(t);
+            if (store.users.empty() && !store.createUserAccount(cmd.str(2), cmd.str(3), Role::ADMIN))
+                throw std::runtime_error("admin account rejected");
+            store.saveUsers();
+            remember(t);
+            return true;
+        }
+        if (op == "tenants" && argc == 0) { report(std::cout); return true; }
+        if (op == "flush" && argc == 0) { writer.flush(); return true; }
+        return runTenantCommand(cmd);
+    }
+};
+
+int runTenantHost(const std::string& dir, size_t maxResident, std::istream& in) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    TenantHost host(dir, maxResident);
+    if (!host.loadRegistry()) return 1;
+    return runCommandScript(in, [&](const CommandLine& cmd) { return host.execute(cmd); });
+}
+
 // --- Event::displayDetails Definition ---
-void Event::displayDetails(const System& sys) const {
-    std::cout << "Event ID: " << eventId << "\n  Name: " << name << "\n  Date: " << date << ", Time: " << time
-              << "\n  Location: " << location << "\n  Category: " << category << "\n  Status: " << getStatusString()
-              << "\n  Description: " << description << "\n  Attendees: " << attendeeIds.size() << "\n";
+void Event::displayDetails(const System& sys, OutputBuffer& out) const {
+    out << "Event ID: " << eventId << "\n  Name: " << name << "\n  Date: " << date.iso() << ", Time: " << time.hhmm()
+        << "\n  Location: " << location << "\n  Category: " << category << "\n  Status: " << getStatusString()
+        << "\n  Description: " << description << "\n  Attendees: " << attendeeIds.size() << "\n";
     if (!allocatedInventory.empty()) {
-        std::cout << "  Inventory:\n";
+        out << "  Inventory:\n";
         for (auto const& [invId, quantity] : allocatedInventory) {
             const InventoryItem* item = sys.findInventoryItemById(invId);
-            std::cout << "    - " << (item ? item->name : "Unknown Item") << " (ID: " << invId << "), Qty: " << quantity << "\n";
+            if (item) out << "    - " << item->name; else out << "    - Unknown Item";
+            out << " (ID: " << invId << "), Qty: " << quantity << "\n";
         }
     } else {
-        std::cout << "  No inventory allocated.\n";
+        out << "  No inventory allocated.\n";
+    }
+}
+
+// A new directory under the system temp dir that the process works in
+// until destruction, which returns to the starting directory and removes
+// it. Named <prefix>-<pid>[-<n>] so concurrent runs never share one.
+struct ScratchDirectory {
+    std::filesystem::path home = std::filesystem::current_path(), path;
+
+    explicit ScratchDirectory(const std::string& prefix) {
+        namespace fs = std::filesystem;
+#if defined(__unix__) || defined(__APPLE__)
+        std::string name = prefix + "-" + std::to_string(getpid());
+#else
+        std::string name = prefix + "-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        path = fs::temp_directory_path() / name;
+        for (int n = 1; !fs::create_directory(path); ++n) path = fs::temp_directory_path() / (name + "-" + std::to_string(n));
+        fs::current_path(path);
+    }
+    ScratchDirectory(const ScratchDirectory&) = delete;
+    ScratchDirectory& operator=(const ScratchDirectory&) = delete;
+    ~ScratchDirectory() {
+        std::error_code ec;
+        std::filesystem::current_path(home, ec);
+        std::filesystem::remove_all(path, ec);
     }
+};
+
+// --- Allocation Check (--alloc-check) ---
+// Runs the read paths that must not touch the heap (lookups, login, listings)
+// against the current data files and reports any that allocate. Each path
+// runs once to warm up reusable buffers, then is measured over 100 calls.
+// The checks seed, save and register, so they work on a copy of the data
+// files in a scratch directory under the system temp dir.
+int runAllocationCheck() {
+    namespace fs = std::filesystem;
+    ScratchDirectory work("ems-alloc-check"); // Outlives sys, whose destructor saves into the copy
+    for (const char* file : {"users.txt", "events.txt", "inventory.txt", "attendees.txt", "registrations.txt"})
+        if (fs::exists(work.home / file)) fs::copy_file(work.home / file, file);
+    System sys;
+    sys.autoSave = false;
+    sys.loadData();
+    sys.seedInitialData();
+    const User* sample = sys.users.front();
+    const std::string& uname = sample->getUsername();
+    const std::string& pwd = sample->getPassword();
+    int eventId = sys.events.empty() ? 0 : sys.events.front().eventId;
+    struct Result { const char* name; size_t allocations; size_t budget; };
+    std::vector<Result> results;
+    results.reserve(16);
+    NullStreamBuf sink;
+    std::streambuf* realOut = std::cout.rdbuf(&sink);
+    auto measure = [&](const char* name, auto op) {
+        op();
+        AllocationScope scope;
+        for (int i = 0; i < 100; ++i) op();
+        size_t n = scope.allocations();
+        results.push_back({name, n, 0});
+    };
+    measure("findUserByUsername", [&] { sys.findUserByUsername(uname); });
+    measure("usernameExists", [&] { sys.usernameExists("no-such-user"); });
+    measure("login+logout", [&] { sys.login(uname, pwd); sys.logout(); });
+    measure("findEventById", [&] { sys.findEventById(eventId); });
+    measure("findInventoryItemByName", [&] { sys.findInventoryItemByName("PROJECTOR"); });
+    measure("listAllUsers", [&] { sys.listAllUsers(); });
+    measure("viewAllEvents", [&] { sys.viewAllEvents(); });
+    // Whole batch commands: temporaries come from the per-request scratch arena
+    std::string searchLine = "search a", rangeLine = "events-between 1900-01-01 2100-12-31";
+    CommandLine search, range;
+    search.parse(searchLine);
+    range.parse(rangeLine);
+    measure("search (command)", [&] { sys.executeCommand(search); });
+    measure("events-between (command)", [&] { sys.executeCommand(range); });
+    // Budgets for operations that may allocate, taken from the per-operation
+    // heap attribution of the latency report (steady state, per 100 calls)
+    auto attributed = [&](const char* name, int op, size_t perCall, auto call) {
+        call();
+        uint64_t calls = 0, before = 0, after = 0, bytes = 0;
+        LatencyStats::totals(op, calls, before, bytes);
+        for (int i = 0; i < 100; ++i) call();
+        LatencyStats::totals(op, calls, after, bytes);
+        results.push_back({name, static_cast<size_t>(after - before), perCall * 100});
+    };
+    attributed("save-events", latency_op::saveEvents, 0, [&] { sys.saveEvents(); });
+    attributed("save-registrations", latency_op::saveRegistrations, 0, [&] { sys.saveRegistrations(); });
+    if (eventId != 0 && sys.login(uname, pwd)) {
+        std::string joinLine = "join-event " + std::to_string(eventId), leaveLine = "leave-event " + std::to_string(eventId);
+        CommandLine join, leave;
+        join.parse(joinLine);
+        leave.parse(leaveLine);
+        if (sys.findRegistration(sys.profileForUser(*sys.currentUser).attendeeId, eventId)) sys.executeCommand(leave);
+        // Join: the registration index node, plus a bitmap container in the
+        // event and in the attendee's event set (leave emptied both)
+        attributed("register-event (join + leave)", latency_op::registerEvent, 3, [&] { sys.executeCommand(join); sys.executeCommand(leave); });
+        attributed("cancel-registration (join + leave)", latency_op::cancelRegistration, 0, [&] { sys.executeCommand(join); sys.executeCommand(leave); });
+        sys.logout();
+    }
+    std::cout.rdbuf(realOut);
+    int failures = 0;
+    for (const Result& r : results) {
+        bool ok = r.allocations <= r.budget;
+        std::cout << (ok ? "ok    " : "FAIL  ") << r.name << ": " << r.allocations << " allocations / 100 calls";
+        if (r.budget) std::cout << " (budget " << r.budget << ")";
+        std::cout << "\n";
+        if (!ok) ++failures;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// --- Synthetic Datasets (--generate) ---
+// Scale n means n users and n attendee profiles, n/20 events and n/200
+// inventory items (at least 1 and 10). The same scale and seed always give
+// the same files.
+struct DatasetSpec {
+    size_t users, attendees, events, items;
+    uint64_t seed;
+    static DatasetSpec forScale(size_t n, uint64_t seed) {
+        return {n, n, std::max<size_t>(1, n / 20), std::max<size_t>(10, n / 200), seed};
+    }
+};
+
+namespace dataset_words {
+constexpr std::string_view firstNames[] = {"Ana", "Ben", "Carla", "Dario", "Elena", "Felix", "Grace", "Hugo", "Iris", "Jon",
+                                           "Kira", "Luis", "Maya", "Nico", "Olga", "Paulo", "Rosa", "Sam", "Tess", "Victor"};
+constexpr std::string_view lastNames[] = {"Santos", "Reyes", "Cruz", "Garcia", "Lim", "Tan", "Mendoza", "Navarro", "Ramos", "Torres",
+                                          "Chen", "Kim", "Nguyen", "Patel", "Smith", "Okafor", "Muller", "Rossi", "Silva", "Ivanova"};
+constexpr std::string_view categories[] = {"Conference", "Workshop", "Social", "Seminar", "Networking", "Concert",
+                                           "Meetup", "Exhibition", "Sports", "Fundraiser", "Festival", "Webinar"};
+constexpr std::string_view cities[] = {"Manila", "Cebu", "Davao", "Iloilo", "Baguio", "Quezon City", "Makati", "Pasig",
+                                       "Taguig", "Bacolod", "Cagayan de Oro", "Zamboanga", "Tacloban", "Dumaguete", "Legazpi"};
+constexpr std::string_view venues[] = {"Convention Center", "Grand Hall", "City Park", "Auditorium", "Hotel Ballroom",
+                                       "Community Center", "Arena", "University Hall", "Rooftop Garden", "Library"};
+constexpr std::string_view topics[] = {"Tech", "Cloud", "Music", "Startup", "Design", "Health", "Data", "Food", "Film",
+                                       "Robotics", "Marketing", "Finance", "Art", "Gaming", "Climate", "Education"};
+constexpr std::string_view formats[] = {"Summit", "Expo", "Night", "Bootcamp", "Forum", "Fair", "Hackathon", "Gala", "Series", "Day"};
+constexpr std::string_view equipment[] = {"Projector", "Chairs", "Tables", "Microphone", "Speaker", "Stage Light",
+                                          "Banner Stand", "Laptop", "Extension Cord", "Whiteboard", "Tent", "Generator"};
+}
+
+// Day `index` counted from Jan 1 of startYear
+Date dateFromDayIndex(unsigned startYear, unsigned index) {
+    unsigned y = startYear, m = 1;
+    while (true) {
+        unsigned days = date_detail::daysInMonth(y, m);
+        if (index < days) return Date::fromYmd(y, m, index + 1);
+        index -= days;
+        if (++m > 12) { m = 1; ++y; }
+    }
+}
+
+// Fills an empty System:
+// - events: Zipfian category mix (s = 1), venues drawn with Zipf (s = 0.9)
+//   from about 2*sqrt(events) named venues, dates spread over 2024-2026,
+//   daytime-heavy start times, status from the date (completed before
+//   2025-06-01, a few cancelled)
+// - attendees: 30% linked to a user account; each registers for 1 + a
+//   geometric number of events (mean about 2.2, at most 20), chosen by
+//   Zipfian popularity (s = 1.07) over a shuffled event order, so a few
+//   events draw most of the crowd; 70% of completed-event registrations
+//   are checked in
+// - inventory: log-uniform quantities, allocated to about a third of events
+void generateDataset(System& sys, const DatasetSpec& spec) {
+    using namespace dataset_words;
+    sys.clearData();
+    SeededRandom root(spec.seed);
+    SeededRandom userRng = root.fork(1), eventRng = root.fork(2), venueRng = root.fork(3);
+    SeededRandom attendeeRng = root.fork(4), itemRng = root.fork(5);
+    static const char kAlphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+    for (size_t i = 0; i < spec.users; ++i) {
+        std::string name = std::string(pick(userRng, firstNames)) + "." + std::string(pick(userRng, lastNames)) + std::to_string(i);
+        for (char& c : name) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        std::string password(10, 'x');
+        for (char& c : password) c = kAlphabet[userRng.below(36)];
+        if (userRng.chance(0.02)) sys.addUser(new Admin(name, password));
+        else sys.addUser(new RegularUser(name, password));
+    }
+
+    size_t venueCount = std::max<size_t>(5, static_cast<size_t>(2 * std::sqrt(double(spec.events))));
+    std::vector<std::string> venueNames;
+    for (size_t v = 0; v < venueCount; ++v) {
+        venueNames.push_back(std::string(pick(venueRng, venues)) + ", " + std::string(pick(venueRng, cities)));
+        if (v >= 150) venueNames.back() += " " + std::to_string(v); // Keep names distinct past the word combinations
+    }
+    ZipfSampler categoryPick(std::size(categories), 1.0), venuePick(venueCount, 0.9);
+    const Date cutoff = dateLiteral("2025-06-01");
+    sys.events.reserve(spec.events);
+    for (size_t i = 0; i < spec.events; ++i) {
+        Date date = dateFromDayIndex(2024, static_cast<unsigned>(eventRng.below(3 * 365)));
+        unsigned slot = eventRng.chance(0.7) ? 8 * 4 + static_cast<unsigned>(eventRng.below(9 * 4))   // 08:00-16:45
+                                             : 17 * 4 + static_cast<unsigned>(eventRng.below(5 * 4)); // 17:00-21:45
+        std::string_view category = categories[categoryPick(eventRng)];
+        std::string name = std::string(pick(eventRng, topics)) + " " + std::string(pick(eventRng, formats)) + " " + std::to_string(date.year());
+        sys.events.emplace_back(std::move(name), date, TimeOfDay{static_cast<uint16_t>(slot * 15)}, venueNames[venuePick(eventRng)],
+                                std::string(category) + " event", std::string(category));
+        Event& event = sys.events.back();
+        if (eventRng.chance(0.04)) event.status = EventStatus::CANCELED;
+        else if (date < cutoff) event.status = EventStatus::COMPLETED;
+    }
+
+    for (size_t i = 0; i < spec.items; ++i) {
+        std::string name = std::string(pick(itemRng, equipment)) + " " + std::to_string(i + 1);
+        int quantity = static_cast<int>(std::exp(itemRng.unit() * std::log(500.0))) + 1; // 1..500, log-uniform
+        sys.inventory.emplace_back(std::move(name), quantity, "Synthetic equipment");
+    }
+    for (Event& event : sys.events) {
+        if (!itemRng.chance(0.33)) continue;
+        InventoryItem& item = sys.inventory[itemRng.below(sys.inventory.size())];
+        int quantity = std::min(1 + static_cast<int>(itemRng.below(5)), item.getAvailableQuantity());
+        if (quantity > 0 && item.allocate(quantity)) event.allocateInventoryItem(item.itemId, quantity);
+    }
+
+    RankShuffle eventOrder(sys.events.size(), attendeeRng);
+    ZipfSampler popularity(sys.events.size(), 1.07);
+    for (size_t i = 0; i < spec.attendees; ++i) {
+        std::string name = std::string(pick(attendeeRng, firstNames)) + " " + std::string(pick(attendeeRng, lastNames));
+        int userId = 0;
+        if (i < sys.users.size() && attendeeRng.chance(0.3)) { userId = sys.users[i]->getUserId(); name = sys.users[i]->getUsername(); }
+        std::string contact = name + "@example.com";
+        for (char& c : contact) c = c == ' ' ? '.' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        int attendeeId = sys.addAttendee(Attendee(std::move(name), std::move(contact), userId)).attendeeId;
+        int registrations = 1;
+        while (registrations < 20 && attendeeRng.chance(0.55)) ++registrations;
+        for (int r = 0; r < registrations; ++r) {
+            for (int attempt = 0; attempt < 3; ++attempt) { // A repeat pick of the same event is retried
+                const Event& event = sys.events[eventOrder(popularity(attendeeRng))];
+                bool checkedIn = event.status == EventStatus::COMPLETED && attendeeRng.chance(0.7);
+                if (sys.addRegistration(attendeeId, event.eventId, checkedIn ? Registration::CHECKED_IN : 0)) break;
+            }
+        }
+    }
+}
+
+// Writes a dataset to dir (created if needed); the files are written once,
+// when the System goes out of scope
+// A whole number above zero, digits only; false otherwise
+bool parseCount(const char* text, uint64_t& out) {
+    if (!text || !std::isdigit(static_cast<unsigned char>(*text))) return false;
+    char* end = nullptr;
+    errno = 0;
+    out = std::strtoull(text, &end, 10);
+    return *end == '\0' && errno == 0 && out > 0;
+}
+
+int runGenerator(const std::string& dir, size_t scale, uint64_t seed) {
+    namespace fs = std::filesystem;
+    fs::create_directories(dir);
+    fs::path home = fs::current_path();
+    fs::current_path(dir);
+    {
+        System sys;
+        sys.autoSave = false;
+        generateDataset(sys, DatasetSpec::forScale(scale, seed));
+        std::cout << "Generated " << sys.users.size() << " users, " << sys.events.size() << " events, "
+                  << sys.allAttendees.size() << " attendees, " << sys.registrations.size() << " registrations, "
+                  << sys.inventory.size() << " inventory items in " << dir << " (seed " << seed << ").\n";
+    }
+    fs::current_path(home);
+    return 0;
+}
+
+// --- Benchmarks (--bench [max-size]) ---
+// For each size n (10^2 up to max-size) generates the scale-n synthetic
+// dataset (fixed seed) and times the core operations. Lookups cycle
+// through existing keys. fromString cycles over pre-rendered lines of up to
+// 10^4 records. Data files are written to a scratch directory under the
+// system temp dir (removed at the end), never over the real ones.
+int runBenchmarks(size_t maxSize) {
+    ScratchDirectory work("ems-bench");
+    std::ostream results(std::cout.rdbuf());
+    NullStreamBuf sink;
+    std::streambuf* realOut = std::cout.rdbuf(&sink); // Listings and save/load chatter
+    {
+        BenchRunner bench(results, "test");
+        for (size_t n : benchSizes(maxSize)) {
+            System sys;
+            sys.autoSave = false;
+            generateDataset(sys, DatasetSpec::forScale(n, 42));
+            size_t events = sys.events.size(), attendees = sys.allAttendees.size(), items = sys.inventory.size();
+            size_t k = 0;
+            bench.run("findUserByUsername", n, [&] { doNotOptimize(sys.findUserByUsername(sys.users[(k++ * 7919) % n]->getUsername())); });
+            bench.run("findEventById", n, [&] { doNotOptimize(sys.findEventById(sys.events[(k++ * 7919) % events].eventId)); });
+            int nextAttendee = 0;
+            Event target = sys.events[events / 2]; // A copy, so the saved data stays consistent
+            bench.run("Event::addAttendee", n, [&] { target.addAttendee(nextAttendee++); });
+            bench.run("User::toString", n, [&] { doNotOptimize(sys.users[k++ % n]->toString()); });
+            bench.run("Event::toString", n, [&] { doNotOptimize(sys.events[k++ % events].toString()); });
+            bench.run("Attendee::toString", n, [&] { doNotOptimize(sys.allAttendees[k++ % attendees].toString()); });
+            bench.run("InventoryItem::toString", n, [&] { doNotOptimize(sys.inventory[k++ % items].toString()); });
+            std::vector<std::string> userLines, eventLines, attendeeLines, itemLines;
+            for (size_t i = 0; i < std::min<size_t>(n, 10000); ++i) userLines.push_back(sys.users[i]->toString());
+            for (size_t i = 0; i < std::min<size_t>(events, 10000); ++i) eventLines.push_back(sys.events[i].toString());
+            for (size_t i = 0; i < std::min<size_t>(attendees, 10000); ++i) attendeeLines.push_back(sys.allAttendees[i].toString());
+            for (size_t i = 0; i < std::min<size_t>(items, 10000); ++i) itemLines.push_back(sys.inventory[i].toString());
+            bench.run("User::fromString", n, [&] { delete User::fromString(userLines[k++ % userLines.size()]); });
+            bench.run("Event::fromString", n, [&] { doNotOptimize(Event::fromString(eventLines[k++ % eventLines.size()])); });
+            bench.run("Attendee::fromString", n, [&] { doNotOptimize(Attendee::fromString(attendeeLines[k++ % attendeeLines.size()])); });
+            bench.run("InventoryItem::fromString", n, [&] { doNotOptimize(InventoryItem::fromString(itemLines[k++ % itemLines.size()])); });
+            bench.run("listAllUsers", n, [&] { sys.listAllUsers(); });
+            bench.run("viewAllEvents", n, [&] { sys.viewAllEvents(); });
+            bench.run("findEventsByName", n, [&] {
+                ScratchArena::Scope request(sys.scratch);
+                doNotOptimize(sys.findEventsByName("cloud summit"));
+            });
+            // Six months inside the generated 2024-2026 span, so the scan finds events
+            constexpr Date rangeStart = dateLiteral("2025-01-01"), rangeEnd = dateLiteral("2025-06-30");
+            bench.run("findEventsBetween", n, [&] {
+                ScratchArena::Scope request(sys.scratch);
+                doNotOptimize(sys.findEventsBetween(rangeStart, rangeEnd));
+            });
+            bench.run("saveData", n, [&] { sys.saveData(); });
+            System reader;
+            reader.autoSave = false;
+            bench.run("loadData", n, [&] { reader.clearData(); reader.loadData(); });
+            reader.clearData(); // Nothing to write back on destruction
+            sys.clearData();
+        }
+    }
+    std::cout.rdbuf(realOut);
+    return 0;
+}
+
+// --- Session Replay (--replay [session|-|builtin] [repeat] [scale]) ---
+// Feeds a session (see session_replay.h) to the menus of System::run,
+// repeat times (default 20), each time on a fresh copy of the same data: the
+// seeded accounts and events, or with a scale the generated dataset plus
+// the seeded admin/user1 accounts. Runs in a scratch directory under the
+// system temp dir. "builtin" (the default) replays the session below.
+constexpr std::string_view kBuiltinSession =
+    "@login-admin\n1\nadmin\nadminpass\n"
+    "@list-users\n1\n3\n"
+    "@logout\n6\n"
+    "@login-user\n1\nuser1\nuser1pass\n"
+    "@browse-events\n1\n"
+    "@search-name\n2\nconference\n"
+    "@search-range\n2\n2025-01-01 2025-12-31\n"
+    "@register\n3\n1\n"
+    "@update-contact\n6\nuser1@example.com\n"
+    "@cancel-registration\n4\n1\n"
+    "@logout\n8\n";
+
+int runReplay(const std::string& path, int repeat, size_t scale) {
+    namespace fs = std::filesystem;
+    ReplaySession session;
+    if (path == "-") session = ReplaySession::parse(std::cin);
+    else if (path == "builtin") { std::istringstream in{std::string(kBuiltinSession)}; session = ReplaySession::parse(in); }
+    else {
+        std::ifstream in(path);
+        if (!in) { std::cerr << "Cannot open session '" << path << "'.\n"; return 1; }
+        session = ReplaySession::parse(in);
+    }
+    fs::path home = fs::current_path(), base = fs::temp_directory_path() / "ems-replay";
+    fs::remove_all(base);
+    fs::create_directories(base / "data");
+    fs::current_path(base / "data");
+    if (scale > 0) {
+        System sys;
+        sys.autoSave = false;
+        generateDataset(sys, DatasetSpec::forScale(scale, 42));
+        sys.addUser(new Admin("admin", "adminpass"));
+        sys.addUser(new RegularUser("user1", "user1pass"));
+    }
+    SessionReplayer replayer(session);
+    for (int r = 0; r < repeat; ++r) {
+        fs::current_path(base);
+        fs::remove_all(base / "run");
+        fs::copy(base / "data", base / "run");
+        fs::current_path(base / "run");
+        size_t unread = replayer.run([] { System sys; sys.run(); });
+        if (unread && r == 0) std::cerr << "Warn: The menus stopped with " << unread << " session lines unread.\n";
+    }
+    fs::current_path(home);
+    fs::remove_all(base);
+    std::ostream results(std::cout.rdbuf());
+    replayer.report(results, "test");
+    return 0;
 }
 
 // --- Main Function ---
-int main() {
+// Usage: test [--batch [script|-] | --alloc-check | --bench [max-size] | --generate <dir> <scale> [seed]
+//             | --replay [session|-|builtin] [repeat] [scale] | --audit-decode <audit.bin>
+//             | --replica <journal> [poll-ms] | --shards <N>
+//             | --restore <history-dir> <epoch-ms | YYYY-MM-DD [HH:MM]> | --tenants <dir> [max-resident]
+//             | --catalog </shm-name>]
+//        (batch mode and the shard router read stdin when no script is given)
+int main(int argc, char* argv[]) {
     try {
         std::locale::global(std::locale(""));
         std::cout.imbue(std::locale());
@@ -912,7 +2778,57 @@ int main() {
     } catch (const std::runtime_error& e) {
         std::cerr << "Warn: Locale setup failed. " << e.what() << std::endl;
     }
+    Tracer::enableFromEnvironment();
+    PerfCounters::enableFromEnvironment(); // EMS_PERF=1
+    SamplingProfiler::enableSignalToggle(); // EMS_PROFILE_SIGNAL=1: kill -USR2 <pid> starts/stops a profile
+    SamplingProfiler::enableFromEnvironment(); // EMS_PROFILE=<file>
+    SlowLog::configureFromEnvironment(); // EMS_SLOW_MS=<ms>, EMS_SLOW_LOG=<file>
+    if (argc >= 2 && std::string(argv[1]) == "--alloc-check") return runAllocationCheck();
+    if (argc >= 3 && std::string(argv[1]) == "--audit-decode") {
+        std::ifstream log(argv[2], std::ios::binary);
+        if (!log) { std::cerr << "Cannot open '" << argv[2] << "'.\n"; return 1; }
+        AuditLog::decode(log, std::cout);
+        return 0;
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--bench") return runBenchmarks(benchMaxSize(argc, argv, 2));
+    if (argc >= 4 && std::string(argv[1]) == "--generate") {
+        uint64_t scale = 0, seed = 1;
+        if (!parseCount(argv[3], scale) || (argc >= 5 && !parseCount(argv[4], seed))) {
+            std::cerr << "Usage: test --generate <dir> <scale> [seed] (scale and seed are numbers above 0).\n";
+            return 1;
+        }
+        return runGenerator(argv[2], scale, seed);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--replay")
+        return runReplay(argc >= 3 ? argv[2] : "builtin", argc >= 4 ? std::atoi(argv[3]) : 20,
+                         argc >= 5 ? std::strtoull(argv[4], nullptr, 10) : 0);
+    std::atexit([] { LatencyStats::dump("latency.txt"); }); // After ~System's final save
+    if (argc >= 3 && std::string(argv[1]) == "--replica") {
+        System replica;
+        return replica.runReplica(argv[2], argc >= 4 ? std::max(1, std::atoi(argv[3])) : 50, std::cin) == 0 ? 0 : 1;
+    }
+    if (argc >= 4 && std::string(argv[1]) == "--restore") {
+        uint64_t ms = 0;
+        if (!parseRestoreTime(argc, argv, 3, ms)) { std::cerr << "Expected <epoch-ms> or <YYYY-MM-DD> [HH:MM].\n"; return 1; }
+        return System::restoreToTime(argv[2], ms);
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--catalog") return printSharedCatalog(argv[2]);
+    if (argc >= 3 && std::string(argv[1]) == "--tenants")
+        return runTenantHost(argv[2], argc >= 4 ? std::strtoull(argv[3], nullptr, 10) : 16, std::cin) == 0 ? 0 : 1;
+    if (argc >= 3 && std::string(argv[1]) == "--shards") {
+        int shards = std::atoi(argv[2]);
+        if (shards < 1 || shards > 64) { std::cerr << "Shard count must be 1-64.\n"; return 1; }
+        return System::runShardRouter(shards, std::cin) == 0 ? 0 : 1;
+    }
+    AuditLog::openFromEnvironment("audit.bin"); // Next to the data files; EMS_AUDIT=<file>|off
     System eventManagementSystem;
+    if (argc >= 2 && std::string(argv[1]) == "--batch") {
+        std::string path = argc >= 3 ? argv[2] : "-";
+        if (path == "-") return eventManagementSystem.runScript(std::cin) == 0 ? 0 : 1;
+        std::ifstream script(path);
+        if (!script) { std::cerr << "Cannot open script '" << path << "'.\n"; return 1; }
+        return eventManagementSystem.runScript(script) == 0 ? 0 : 1;
+    }
     eventManagementSystem.run();
     return 0;
 }
\ No newline at end of file
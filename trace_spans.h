@@ -0,0 +1,159 @@
+#ifndef TRACE_SPANS_H
+#define TRACE_SPANS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+#include <string>
+
+// ** Trace spans **
+// Scoped spans around hot paths (load/save phases, index maintenance,
+// registration, queries, reports), written out as Chrome trace JSON that
+// chrome://tracing or ui.perfetto.dev opens as a timeline:
+//
+//     { TraceSpan span("loadEvents", "load"); ... }
+//
+// Tracing is off by default and can be switched at runtime (Tracer::enable,
+// the "trace" batch command, or EMS_TRACE=<file> at startup, which also
+// writes the file at exit). While off, a span costs one relaxed atomic load
+// and a branch. While on, a finished span is appended to its thread's ring
+// buffer (kRingSize spans; the oldest are overwritten), with no lock and no
+// allocation after the ring exists. Names and categories must be string
+// literals: only the pointers are stored.
+// Writing the JSON drains every thread's ring. It is meant to run while no
+// other thread is tracing (both programs are single-threaded); a span
+// written concurrently may be lost.
+
+class Tracer {
+public:
+    static constexpr uint32_t kRingSize = 1 << 16;
+
+    struct Span {
+        const char* name;
+        const char* category;
+        uint64_t startNs;
+        uint64_t durationNs;
+    };
+
+    static bool enabled() { return on().load(std::memory_order_relaxed); }
+    static void enable(bool value) { on().store(value, std::memory_order_relaxed); }
+
+    // Nanoseconds since the first call (the trace's time zero)
+    static uint64_t now() {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count());
+    }
+
+    static void record(const char* name, const char* category, uint64_t startNs, uint64_t endNs) {
+        Ring& ring = threadRing();
+        uint64_t n = ring.written.load(std::memory_order_relaxed);
+        ring.spans[n % kRingSize] = {name, category, startNs, endNs - startNs};
+        ring.written.store(n + 1, std::memory_order_release);
+    }
+
+    // Writes all buffered spans as a Chrome trace and empties the rings.
+    // Returns the number of spans written.
+    static size_t writeChromeJson(std::ostream& out) {
+        out << "{\"traceEvents\":[\n";
+        size_t count = 0;
+        for (Ring* ring = head().load(std::memory_order_acquire); ring; ring = ring->next) {
+            uint64_t end = ring->written.load(std::memory_order_acquire);
+            uint64_t begin = end > kRingSize ? end - kRingSize : ring->drained;
+            if (begin < ring->drained) begin = ring->drained;
+            for (uint64_t i = begin; i < end; ++i) {
+                const Span& s = ring->spans[i % kRingSize];
+                if (count++) out << ",\n";
+                out << "{\"name\":\"";
+                writeEscaped(out, s.name);
+                out << "\",\"cat\":\"";
+                writeEscaped(out, s.category);
+                out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->threadId << ",\"ts\":";
+                writeMicros(out, s.startNs);
+                out << ",\"dur\":";
+                writeMicros(out, s.durationNs);
+                out << '}';
+            }
+            ring->drained = end;
+        }
+        out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        return count;
+    }
+
+    static bool writeChromeJson(const std::string& path, size_t* spans = nullptr) {
+        std::ofstream file(path);
+        if (!file) return false;
+        size_t n = writeChromeJson(file);
+        if (spans) *spans = n;
+        return static_cast<bool>(file);
+    }
+
+    // EMS_TRACE=<file>: trace from startup and write the file at exit
+    static void enableFromEnvironment() {
+        const char* path = std::getenv("EMS_TRACE");
+        if (!path || !*path) return;
+        enable(true);
+        std::atexit([] { writeChromeJson(std::getenv("EMS_TRACE")); });
+    }
+
+private:
+    struct Ring {
+        Span spans[kRingSize];
+        std::atomic<uint64_t> written{0};
+        uint64_t drained = 0;
+        uint32_t threadId = 0;
+        Ring* next = nullptr;
+    };
+
+    static std::atomic<bool>& on() { static std::atomic<bool> flag{false}; return flag; }
+    static std::atomic<Ring*>& head() { static std::atomic<Ring*> h{nullptr}; return h; }
+
+    // The calling thread's ring, pushed onto the list (lock-free) on first use
+    static Ring& threadRing() {
+        thread_local Ring* ring = nullptr;
+        if (!ring) {
+            static std::atomic<uint32_t> nextThreadId{1};
+            ring = new Ring();
+            ring->threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+            Ring* old = head().load(std::memory_order_relaxed);
+            do { ring->next = old; } while (!head().compare_exchange_weak(old, ring, std::memory_order_release, std::memory_order_relaxed));
+        }
+        return *ring;
+    }
+
+    static void writeEscaped(std::ostream& out, const char* s) {
+        for (; *s; ++s) {
+            if (*s == '"' || *s == '\\') out << '\\';
+            out << *s;
+        }
+    }
+
+    // Microseconds with nanosecond digits, without touching the stream's
+    // locale or float format
+    static void writeMicros(std::ostream& out, uint64_t ns) {
+        char frac[4] = {char('0' + ns / 100 % 10), char('0' + ns / 10 % 10), char('0' + ns % 10), '\0'};
+        out << std::to_string(ns / 1000) << '.' << frac;
+    }
+};
+
+// Records the enclosing scope as one span (when tracing is on at entry)
+class TraceSpan {
+private:
+    const char* name;
+    const char* category;
+    uint64_t start;
+
+public:
+    explicit TraceSpan(const char* spanName, const char* spanCategory = "app")
+        : name(spanName), category(spanCategory), start(Tracer::enabled() ? Tracer::now() : UINT64_MAX) {}
+    ~TraceSpan() {
+        if (start != UINT64_MAX) Tracer::record(name, category, start, Tracer::now());
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#endif // TRACE_SPANS_H
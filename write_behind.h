@@ -0,0 +1,123 @@
+#ifndef WRITE_BEHIND_H
+#define WRITE_BEHIND_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ** WriteBehindPool **
+// A few background threads that write whole files for any number of
+// owners (the tenant stores of test --tenants), so a save costs the caller
+// one copy of the rendered file. Writes to the same path are coalesced: a
+// newer submission replaces one that has not started yet, and a path is
+// never written by two threads at once. Each file is written to
+// "<path>.tmp" and renamed over the old one, so a crash leaves either the
+// old or the new contents.
+//
+//     WriteBehindPool writer(2);
+//     writer.submit("acme/users.txt", std::move(contents));
+//     writer.flush(); // everything submitted so far is on disk
+
+class WriteBehindPool {
+private:
+    std::mutex lock;
+    std::condition_variable wake;  // Work arrived or stopping
+    std::condition_variable idle;  // A write finished
+    std::map<std::string, std::string> pending; // path -> latest contents
+    std::set<std::string> writing;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+    uint64_t written = 0, coalesced = 0, failed = 0;
+
+    static bool writeFile(const std::string& path, const std::string& contents) {
+        std::string temp = path + ".tmp";
+        std::FILE* f = std::fopen(temp.c_str(), "wb");
+        if (!f) return false;
+        bool ok = contents.empty() || std::fwrite(contents.data(), 1, contents.size(), f) == contents.size();
+        ok = (std::fclose(f) == 0) && ok;
+        return ok && std::rename(temp.c_str(), path.c_str()) == 0;
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            auto next = pending.begin();
+            while (next != pending.end() && writing.count(next->first)) ++next;
+            if (next == pending.end()) {
+                if (stopping && pending.empty()) return;
+                wake.wait(guard);
+                continue;
+            }
+            std::string path = next->first;
+            std::string contents = std::move(next->second);
+            pending.erase(next);
+            writing.insert(path);
+            guard.unlock();
+            bool ok = writeFile(path, contents);
+            guard.lock();
+            writing.erase(path);
+            ++(ok ? written : failed);
+            idle.notify_all();
+            wake.notify_all(); // A newer version of this path may be waiting
+        }
+    }
+
+public:
+    explicit WriteBehindPool(unsigned threadCount = 2) {
+        for (unsigned i = 0; i < (threadCount ? threadCount : 1); ++i) threads.emplace_back([this] { work(); });
+    }
+    WriteBehindPool(const WriteBehindPool&) = delete;
+    WriteBehindPool& operator=(const WriteBehindPool&) = delete;
+
+    // Writes whatever is still pending, then stops the threads
+    ~WriteBehindPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    void submit(std::string path, std::string contents) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto [it, inserted] = pending.try_emplace(std::move(path));
+            if (!inserted) ++coalesced;
+            it->second = std::move(contents);
+        }
+        wake.notify_one();
+    }
+
+    // Waits until everything submitted so far has been written
+    void flush() {
+        std::unique_lock<std::mutex> guard(lock);
+        idle.wait(guard, [this] { return pending.empty() && writing.empty(); });
+    }
+
+    // Waits until no path starting with prefix is pending or being written
+    // (e.g. before reading back files an owner has just saved)
+    void flush(const std::string& prefix) {
+        auto busy = [&](const std::string& path) { return path.compare(0, prefix.size(), prefix) == 0; };
+        std::unique_lock<std::mutex> guard(lock);
+        idle.wait(guard, [&] {
+            return std::none_of(pending.begin(), pending.end(), [&](const auto& entry) { return busy(entry.first); })
+                   && std::none_of(writing.begin(), writing.end(), busy);
+        });
+    }
+
+    struct Stats { uint64_t written, coalesced, failed; size_t pending; };
+    Stats stats() {
+        std::lock_guard<std::mutex> guard(lock);
+        return Stats{written, coalesced, failed, pending.size() + writing.size()};
+    }
+};
+
+#endif // WRITE_BEHIND_H